@@ -0,0 +1,102 @@
+#include <rbtree.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Compares the balancing engines on the same workloads, once with random keys
+// and once with keys inserted in ascending order:
+//   insert  - n inserts into an empty tree
+//   find    - n random hits on the full tree
+//   mixed   - n operations, 95% find / 5% erase+insert (read-heavy)
+//   erase   - erase every key
+// Usage: bench-rbtree [n] [seed]
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int height(const rbtree *t, const node_t *p) {
+  if (p == t->nil) {
+    return 0;
+  }
+  const int l = height(t, p->left), r = height(t, p->right);
+  return 1 + (l > r ? l : r);
+}
+
+static void report(const char *name, const size_t ops, const double sec) {
+  printf("  %-7s %10.2f Mops/s\n", name, ops / sec / 1e6);
+}
+
+static void bench(const char *name, const balance_t balance, const key_t *keys,
+                  const size_t *probes, const size_t n) {
+  printf("%s\n", name);
+  rbtree *t = new_rbtree_with_balance(balance);
+
+  double start = now();
+  for (size_t i = 0; i < n; i++) {
+    rbtree_insert(t, keys[i]);
+  }
+  report("insert", n, now() - start);
+  printf("  %-7s %10d\n", "height", height(t, t->root));
+
+  size_t hits = 0;
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    hits += rbtree_find(t, keys[probes[i]]) != NULL;
+  }
+  report("find", n, now() - start);
+
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    const key_t key = keys[probes[i]];
+    if (i % 20 == 0) {
+      rbtree_erase(t, rbtree_find(t, key));
+      rbtree_insert(t, key);
+    } else {
+      hits += rbtree_find(t, key) != NULL;
+    }
+  }
+  report("mixed", n, now() - start);
+
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    rbtree_erase(t, rbtree_find(t, keys[i]));
+  }
+  report("erase", n, now() - start);
+
+  if (hits == 0) {
+    printf("unexpected: no hits\n");
+  }
+  delete_rbtree(t);
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const unsigned int seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+
+  srand(seed);
+  key_t *keys = calloc(n, sizeof(key_t));
+  size_t *probes = calloc(n, sizeof(size_t));
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = rand();
+    probes[i] = (size_t)rand() % n;
+  }
+
+  printf("n = %zu, seed = %u\n\n[random keys]\n", n, seed);
+  bench("red-black", RBTREE_BALANCE_RB, keys, probes, n);
+  bench("avl", RBTREE_BALANCE_AVL, keys, probes, n);
+  bench("wavl", RBTREE_BALANCE_WAVL, keys, probes, n);
+
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = (key_t)i;
+  }
+  printf("\n[ascending keys]\n");
+  bench("red-black", RBTREE_BALANCE_RB, keys, probes, n);
+  bench("avl", RBTREE_BALANCE_AVL, keys, probes, n);
+  bench("wavl", RBTREE_BALANCE_WAVL, keys, probes, n);
+
+  free(probes);
+  free(keys);
+}
@@ -0,0 +1,94 @@
+#include <rbtree_str.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Measures str_rbtree lookups on URL keys that all start with the same host:
+//   insert  - n inserts into an empty tree
+//   find    - n random hits on the full tree
+//   ties    - share of non-matching comparisons whose cached prefixes were
+//             equal or stale, so the key bytes had to be read from the arena
+// Usage: bench-str [n] [seed]
+
+// rbtree_str.c
+uint64_t make_prefix(const char *key, size_t len);
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, const size_t ops, const double sec) {
+  printf("  %-7s %10.2f Mops/s\n", name, ops / sec / 1e6);
+}
+
+// walks the same path as str_rbtree_find and counts prefix ties on the way
+static void count_ties(const str_rbtree *t, const char *key, const size_t len,
+                       size_t *steps, size_t *ties) {
+  const size_t c = t->common_len;
+  const uint64_t prefix = make_prefix(key + c, len - c);
+  const node_t *current = t->tree.root;
+  while (current != t->tree.nil) {
+    const str_node_t *node = (const str_node_t *)current;
+    const int cmp = strcmp(key, node->key);
+    if (cmp == 0) {
+      return;
+    }
+    (*steps)++;
+    *ties += node->prefix_at != c || node->prefix == prefix;
+    current = cmp < 0 ? current->left : current->right;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  const unsigned int seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+
+  srand(seed);
+  char **keys = calloc(n, sizeof(char *));
+  size_t *lens = calloc(n, sizeof(size_t));
+  size_t *probes = calloc(n, sizeof(size_t));
+  char buf[128];
+  for (size_t i = 0; i < n; i++) {
+    lens[i] = snprintf(buf, sizeof(buf),
+                       "https://www.example.com/products/%u/reviews?page=%u",
+                       (unsigned)rand(), (unsigned)rand() % 100);
+    keys[i] = strdup(buf);
+    probes[i] = (size_t)rand() % n;
+  }
+  printf("n = %zu, seed = %u\n", n, seed);
+
+  str_rbtree *t = new_str_rbtree();
+  double start = now();
+  for (size_t i = 0; i < n; i++) {
+    str_rbtree_insert(t, keys[i], lens[i]);
+  }
+  report("insert", n, now() - start);
+  printf("  %-7s %10zu\n", "common", t->common_len);
+
+  size_t hits = 0;
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    hits += str_rbtree_find(t, keys[probes[i]], lens[probes[i]]) != NULL;
+  }
+  report("find", n, now() - start);
+
+  size_t steps = 0, ties = 0;
+  for (size_t i = 0; i < n; i++) {
+    count_ties(t, keys[probes[i]], lens[probes[i]], &steps, &ties);
+  }
+  printf("  %-7s %9.2f%%\n", "ties", steps ? 100.0 * ties / steps : 0.0);
+
+  if (hits != n) {
+    printf("unexpected: %zu of %zu hits\n", hits, n);
+  }
+  delete_str_rbtree(t);
+  for (size_t i = 0; i < n; i++) {
+    free(keys[i]);
+  }
+  free(probes);
+  free(lens);
+  free(keys);
+}
@@ -0,0 +1,152 @@
+#include "rbset.h"
+#include <stdlib.h>
+#include <string.h>
+
+// tree가 이 개수까지 줄어들면 배열로 되돌린다. (경계에서 승격/강등이 반복되지 않도록 절반으로 둔다.)
+#define RBSET_DEMOTE_SIZE (RBSET_INLINE_MAX / 2)
+
+size_t count_less(const rbset *s, const key_t key);
+size_t count_less_equal(const rbset *s, const key_t key);
+void promote_to_tree(rbset *s);
+void demote_to_array(rbset *s);
+
+/* 1️⃣ set 생성 */
+// 빈 set은 배열 모드로 시작하므로 rbtree와 nil 노드를 할당하지 않는다.
+rbset *new_rbset(void)
+{
+  return (rbset *)calloc(1, sizeof(rbset));
+}
+
+/* 2️⃣ set 메모리 반환 */
+void delete_rbset(rbset *s)
+{
+  if (s->is_tree)
+    delete_rbtree(s->tree);
+  free(s);
+}
+
+/* 3️⃣ key 추가 */
+// 배열이 가득 찬 상태에서 추가하면 tree로 승격한다.
+int rbset_insert(rbset *s, const key_t key)
+{
+  if (!s->is_tree && s->size == RBSET_INLINE_MAX)
+    promote_to_tree(s);
+
+  if (s->is_tree)
+  {
+    rbtree_insert(s->tree, key);
+    s->size++;
+    return 0;
+  }
+
+  // 같은 key 뒤에 삽입 (rbtree_insert와 같은 순서)
+  size_t pos = count_less_equal(s, key);
+  memmove(&s->keys[pos + 1], &s->keys[pos], (s->size - pos) * sizeof(key_t));
+  s->keys[pos] = key;
+  s->size++;
+  return 0;
+}
+
+/* 4️⃣ 탐색 1 - key 탐색 */
+// key가 있으면 1, 없으면 0 반환
+int rbset_find(const rbset *s, const key_t key)
+{
+  if (s->is_tree)
+    return rbtree_find(s->tree, key) != NULL;
+
+  size_t pos = count_less(s, key);
+  return pos < s->size && s->keys[pos] == key;
+}
+
+/* 4️⃣ 탐색 2 - 최소값 탐색 */
+// 최소값을 `key`에 담는 함수 (set이 비어있으면 -1 반환)
+int rbset_min(const rbset *s, key_t *key)
+{
+  if (s->size == 0)
+    return -1;
+  *key = s->is_tree ? rbtree_min(s->tree)->key : s->keys[0];
+  return 0;
+}
+
+/* 4️⃣ 탐색 3 - 최대값 탐색 */
+// 최대값을 `key`에 담는 함수 (set이 비어있으면 -1 반환)
+int rbset_max(const rbset *s, key_t *key)
+{
+  if (s->size == 0)
+    return -1;
+  *key = s->is_tree ? rbtree_max(s->tree)->key : s->keys[s->size - 1];
+  return 0;
+}
+
+/* 5️⃣ array로 변환 */
+int rbset_to_array(const rbset *s, key_t *arr, const size_t n)
+{
+  if (s->is_tree)
+    return rbtree_to_array(s->tree, arr, n);
+
+  memcpy(arr, s->keys, (n < s->size ? n : s->size) * sizeof(key_t));
+  return 0;
+}
+
+/* 6️⃣ key 삭제 */
+// key 하나를 삭제하는 함수 (없으면 -1 반환), tree가 충분히 작아지면 배열로 강등한다.
+int rbset_erase(rbset *s, const key_t key)
+{
+  if (s->is_tree)
+  {
+    node_t *p = rbtree_find(s->tree, key);
+    if (p == NULL)
+      return -1;
+    rbtree_erase(s->tree, p);
+    s->size--;
+    if (s->size <= RBSET_DEMOTE_SIZE)
+      demote_to_array(s);
+    return 0;
+  }
+
+  size_t pos = count_less(s, key);
+  if (pos == s->size || s->keys[pos] != key)
+    return -1;
+  memmove(&s->keys[pos], &s->keys[pos + 1], (s->size - pos - 1) * sizeof(key_t));
+  s->size--;
+  return 0;
+}
+
+// `key`보다 작은 key의 개수 (= key가 처음 나타나는 위치)
+// 배열이 작으므로 분기 없이 전부 세는 편이 이진 탐색보다 빠르고, 컴파일러가 SIMD로 벡터화할 수 있다.
+size_t count_less(const rbset *s, const key_t key)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < s->size; i++)
+    count += s->keys[i] < key;
+  return count;
+}
+
+// `key`보다 작거나 같은 key의 개수 (= 같은 key 중 마지막 다음 위치)
+size_t count_less_equal(const rbset *s, const key_t key)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < s->size; i++)
+    count += s->keys[i] <= key;
+  return count;
+}
+
+// 배열의 key로 tree를 만드는 함수
+// 작은 set이 많을 때 승격된 set마다 노드 블록을 잡지 않도록 노드는 rbtree_insert로 하나씩 할당한다.
+void promote_to_tree(rbset *s)
+{
+  rbtree *t = new_rbtree();
+  for (size_t i = 0; i < s->size; i++)
+    rbtree_insert(t, s->keys[i]);
+  s->tree = t;
+  s->is_tree = 1;
+}
+
+// tree의 key를 배열로 옮기고 tree를 반환하는 함수
+void demote_to_array(rbset *s)
+{
+  rbtree *t = s->tree;
+  s->is_tree = 0;
+  rbtree_to_array(t, s->keys, s->size);
+  delete_rbtree(t);
+}
@@ -0,0 +1,30 @@
+#ifndef _RBSET_H_
+#define _RBSET_H_
+
+#include "rbtree.h"
+
+#define RBSET_INLINE_MAX 16  // 이 개수까지는 정렬된 배열에 직접 저장
+
+// key 개수가 적을 때는 구조체 안의 정렬된 배열에, 많아지면 rbtree에 저장하는 ordered multiset
+// 배열에 담긴 key에는 노드가 없으므로, rbtree_* 함수와 같은 연산을 node_t 대신 key로 주고받는다.
+typedef struct {
+  size_t size;
+  int is_tree;  // 1이면 tree, 0이면 keys 사용
+  union {
+    key_t keys[RBSET_INLINE_MAX];  // 오름차순 정렬
+    rbtree *tree;
+  };
+} rbset;
+
+rbset *new_rbset(void);
+void delete_rbset(rbset *);
+
+int rbset_insert(rbset *, const key_t);
+int rbset_find(const rbset *, const key_t);
+int rbset_min(const rbset *, key_t *);
+int rbset_max(const rbset *, key_t *);
+int rbset_erase(rbset *, const key_t);
+
+int rbset_to_array(const rbset *, key_t *, const size_t);
+
+#endif  // _RBSET_H_
@@ -1,25 +1,121 @@
 #include "rbtree.h"
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+
+// 노드 블록은 NODE_BLOCK_BYTES 경계에 맞춰 할당하므로, 노드 주소의 하위 비트를 지우면 블록 헤더가 나온다.
+#define NODE_BLOCK_BYTES 16384
+#define NODE_BLOCK_NODES ((NODE_BLOCK_BYTES - sizeof(node_block_t)) / sizeof(node_t))
+// 남은 노드가 이보다 적으면 새 블록 대신 노드마다 따로 할당한다. (블록의 절반도 못 채울 batch가 16 KiB를 잡지 않도록)
+#define NODE_BLOCK_MIN_BATCH (NODE_BLOCK_NODES / 2)
+// 지연 삭제 모드에서 dead 비율이 기준을 넘었을 때 rbtree_erase 한 번이 실제로 제거하는 삭제 표시 노드 수
+// 삭제 한 번에 dead가 하나 늘어나므로 1보다 커야 비율이 다시 내려간다.
+#define LAZY_PURGE_PER_ERASE 2
+
+struct node_block_t
+{
+  struct node_block_t *prev, *next;
+  size_t live; // 재사용 목록에 있지 않은(트리에서 쓰이는) 노드 개수, 0이 되면 블록을 반환
+  node_t nodes[];
+};
+
+// 해시 인덱스: key를 slot에 함께 저장해 탐색 중에는 노드를 읽지 않는다. (node가 NULL이면 빈 slot)
+typedef struct
+{
+  key_t key;
+  node_t *node;
+} hash_slot_t;
+
+struct hash_index_t
+{
+  int bits; // slot 개수 = 2^bits
+  size_t count;
+  hash_slot_t *slots;
+};
+
+// rbtree_delete_async로 넘겨받은 tree를 반환하는 background 스레드의 작업 큐
+typedef struct reclaim_entry_t
+{
+  rbtree *tree;
+  struct reclaim_entry_t *next;
+} reclaim_entry_t;
+
+static struct
+{
+  pthread_once_t once;
+  pthread_mutex_t lock;
+  pthread_cond_t wake, done;
+  reclaim_entry_t *head, *tail;
+  size_t pending; // 큐에 있거나 반환 중인 tree 개수
+  int started;    // 스레드 생성에 성공했으면 1
+} reclaimer = {PTHREAD_ONCE_INIT, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER};
 
 void traverse_and_delete_node(rbtree *t, node_t *node);
+void start_reclaimer(void);
+void *reclaimer_main(void *arg);
+node_t *alloc_node(rbtree *t);
+node_t *alloc_block_node(rbtree *t);
+void add_node_block(rbtree *t);
+void release_node(rbtree *t, node_t *node);
+void unlink_free_node(rbtree *t, node_t *node);
+node_t *attach_node(rbtree *t, node_t *new_node, node_t *current);
+node_t *find_finger_start(rbtree *t, node_t *finger, const key_t key);
+void rebuild_with_nodes(rbtree *t, node_t **new_nodes, const size_t n);
+node_t *build_balanced(rbtree *t, node_t **nodes, size_t lo, size_t hi, node_t *parent, int depth, int red_depth);
+int compare_key(const void *a, const void *b);
+void rebalance_after_insert(rbtree *t, node_t *node);
+void rebalance_after_erase(rbtree *t, node_t *parent, int is_left, int is_remove_black);
+void unlink_node(rbtree *t, node_t *delete);
+void purge_dead_nodes(rbtree *t, size_t max_nodes);
+node_t *find_dead_node(const rbtree *t);
+void update_subtree_flags(node_t *node);
+void update_subtree_flags_upward(rbtree *t, node_t *node);
 void rbtree_insert_fixup(rbtree *t, node_t *node);
+void avl_rebalance(rbtree *t, node_t *node);
+node_t *avl_fix_node(rbtree *t, node_t *node);
+void update_height(node_t *node);
+void wavl_insert_fixup(rbtree *t, node_t *node);
+void wavl_erase_fixup(rbtree *t, node_t *parent, int is_left);
 void left_rotate(rbtree *t, node_t *node);
 void right_rotate(rbtree *t, node_t *node);
+node_t *find_in_subtree(const rbtree *t, node_t *current, const key_t key);
 node_t *get_next_node(const rbtree *t, node_t *p);
+node_t *get_prev_node(const rbtree *t, node_t *p);
+node_t *get_next_live_node(const rbtree *t, node_t *p);
+node_t *subtree_min_live(const rbtree *t, node_t *node);
+node_t *subtree_max_live(const rbtree *t, node_t *node);
 void rbtree_erase_fixup(rbtree *t, node_t *parent, int is_left);
 void exchange_color(node_t *a, node_t *b);
+size_t hash_home(const hash_index_t *index, const key_t key);
+void hash_index_resize(hash_index_t *index, int bits);
+void hash_index_insert(rbtree *t, node_t *node);
+void hash_index_remove(rbtree *t, node_t *node);
+hash_slot_t *hash_index_slot(const hash_index_t *index, const key_t key);
+node_t *find_equal_live_neighbor(const rbtree *t, node_t *node);
+node_t *hash_index_find(const hash_index_t *index, const key_t key);
 
 /* 1️⃣ RB tree 구조체 생성 */
 // 새 트리를 생성하는 함수
 rbtree *new_rbtree(void)
+{
+  return new_rbtree_with_balance(RBTREE_DEFAULT_BALANCE);
+}
+
+// 균형 유지 방식을 지정해 새 트리를 생성하는 함수
+// RB: 갱신 비용이 가장 작다 / AVL: 높이가 가장 낮다 (<= 1.44 log n)
+// WAVL: 삭제당 회전이 최대 2번이고, 삭제가 없으면 AVL과 같은 높이를 유지한다.
+rbtree *new_rbtree_with_balance(const balance_t balance)
 {
   // tree 구조체 동적 할당
   rbtree *t = (rbtree *)calloc(1, sizeof(rbtree));
+  t->balance = balance;
 
   // nil 노드 생성 및 초기화
   node_t *nil = (node_t *)calloc(1, sizeof(node_t));
   nil->color = RBTREE_BLACK; // nil 노드는 항상 BLACK
+  nil->flags = NODE_NO_LIVE; // nil 노드 아래에는 살아있는 노드가 없다.
 
   // tree의 nil과 root를 nil 노드로 설정 (tree가 빈 경우 root는 nil노드여야 한다.)
   t->nil = t->root = nil;
@@ -32,23 +128,210 @@ rbtree *new_rbtree(void)
 void delete_rbtree(rbtree *t)
 {
   node_t *node = t->root;
-  if (node != t->nil)
+  // 모든 노드가 블록에 속해 있으면 노드를 하나씩 방문할 필요 없이 블록만 반환하면 된다.
+  if (node != t->nil && t->heap_nodes > 0)
     traverse_and_delete_node(t, node);
 
+  // 일괄 할당한 노드 블록은 블록 단위로 반환
+  node_block_t *block = t->blocks;
+  while (block != NULL)
+  {
+    node_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  rbtree_disable_hash_index(t);
+
   // nil 노드와 rbtree 구조체의 메모리를 반환
   free(t->nil);
   free(t);
 }
 
 // 각 노드와 그 자식 노드들의 메모리를 반환하는 함수
+// 재귀 대신 왼쪽 자식을 위로 올리는 회전으로 트리를 오른쪽으로 펼치면서 반환하므로 추가 메모리가 O(1)이다.
 void traverse_and_delete_node(rbtree *t, node_t *node)
 {
-  if (node->left != t->nil)
-    traverse_and_delete_node(t, node->left);
-  if (node->right != t->nil)
-    traverse_and_delete_node(t, node->right);
-  // 현재 노드의 메모리를 반환
-  free(node);
+  while (node != t->nil)
+  {
+    node_t *left = node->left;
+    if (left != t->nil)
+    { // 왼쪽 자식이 있으면 오른쪽으로 회전 (부모 포인터는 곧 반환되므로 갱신하지 않음)
+      node->left = left->right;
+      left->right = node;
+      node = left;
+      continue;
+    }
+
+    // 왼쪽 자식이 없으면 현재 노드를 반환하고 오른쪽으로 이동
+    node_t *right = node->right;
+    // 블록에 속한 노드는 delete_rbtree에서 블록째 반환
+    if (!(node->flags & NODE_IN_BLOCK))
+      free(node);
+    node = right;
+  }
+}
+
+// tree를 background 스레드에서 반환하는 함수
+// 호출 즉시 반환되며, 이후 `t`와 `t`의 노드를 사용하면 안 된다.
+// 스레드를 만들 수 없으면 호출한 스레드에서 바로 반환한다.
+void rbtree_delete_async(rbtree *t)
+{
+  pthread_once(&reclaimer.once, start_reclaimer);
+  if (!reclaimer.started)
+  {
+    delete_rbtree(t);
+    return;
+  }
+
+  reclaim_entry_t *entry = (reclaim_entry_t *)malloc(sizeof(reclaim_entry_t));
+  entry->tree = t;
+  entry->next = NULL;
+
+  pthread_mutex_lock(&reclaimer.lock);
+  if (reclaimer.tail != NULL)
+    reclaimer.tail->next = entry;
+  else
+    reclaimer.head = entry;
+  reclaimer.tail = entry;
+  reclaimer.pending++;
+  pthread_cond_signal(&reclaimer.wake);
+  pthread_mutex_unlock(&reclaimer.lock);
+}
+
+// rbtree_delete_async로 넘긴 tree가 모두 반환될 때까지 기다리는 함수
+void rbtree_reclaim_wait(void)
+{
+  pthread_mutex_lock(&reclaimer.lock);
+  while (reclaimer.pending > 0)
+    pthread_cond_wait(&reclaimer.done, &reclaimer.lock);
+  pthread_mutex_unlock(&reclaimer.lock);
+}
+
+void start_reclaimer(void)
+{
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, reclaimer_main, NULL) != 0)
+    return;
+  pthread_detach(thread);
+  reclaimer.started = 1;
+}
+
+// 큐에서 tree를 하나씩 꺼내 delete_rbtree로 반환하는 background 스레드
+void *reclaimer_main(void *arg)
+{
+  pthread_mutex_lock(&reclaimer.lock);
+  while (1)
+  {
+    while (reclaimer.head == NULL)
+      pthread_cond_wait(&reclaimer.wake, &reclaimer.lock);
+
+    reclaim_entry_t *entry = reclaimer.head;
+    reclaimer.head = entry->next;
+    if (reclaimer.head == NULL)
+      reclaimer.tail = NULL;
+
+    // 반환하는 동안에는 lock을 풀어 다른 스레드가 계속 큐에 넣을 수 있게 한다.
+    pthread_mutex_unlock(&reclaimer.lock);
+    delete_rbtree(entry->tree);
+    free(entry);
+    pthread_mutex_lock(&reclaimer.lock);
+
+    if (--reclaimer.pending == 0)
+      pthread_cond_broadcast(&reclaimer.done);
+  }
+  return NULL;
+}
+
+// 새 노드를 할당하는 함수: 블록에 남는 노드가 있으면 재사용한다.
+node_t *alloc_node(rbtree *t)
+{
+  if (t->free_nodes == NULL)
+  {
+    t->heap_nodes++;
+    return (node_t *)calloc(1, sizeof(node_t));
+  }
+  return alloc_block_node(t);
+}
+
+// 블록에서 노드를 하나 꺼내는 함수: 남는 노드가 없을 때만 새 블록을 할당한다.
+node_t *alloc_block_node(rbtree *t)
+{
+  if (t->free_nodes == NULL)
+    add_node_block(t);
+
+  node_t *node = t->free_nodes;
+  unlink_free_node(t, node);
+  ((node_block_t *)((uintptr_t)node & ~(uintptr_t)(NODE_BLOCK_BYTES - 1)))->live++;
+  memset(node, 0, sizeof(node_t));
+  node->flags = NODE_IN_BLOCK;
+  return node;
+}
+
+// 새 블록을 할당해 모든 노드를 재사용 목록에 넣는 함수
+void add_node_block(rbtree *t)
+{
+  node_block_t *block = (node_block_t *)aligned_alloc(NODE_BLOCK_BYTES, NODE_BLOCK_BYTES);
+  block->prev = NULL;
+  block->next = t->blocks;
+  block->live = 0;
+  if (t->blocks != NULL)
+    t->blocks->prev = block;
+  t->blocks = block;
+
+  for (size_t i = NODE_BLOCK_NODES; i-- > 0;)
+  {
+    node_t *node = &block->nodes[i];
+    node->left = NULL;
+    node->right = t->free_nodes;
+    if (t->free_nodes != NULL)
+      t->free_nodes->left = node;
+    t->free_nodes = node;
+  }
+}
+
+// 트리에서 떨어져 나온 노드를 반환하는 함수
+// 블록에 속한 노드는 재사용 목록으로 보내고, 블록의 노드가 모두 반환됐으면 블록째 반환한다.
+void release_node(rbtree *t, node_t *node)
+{
+  if (!(node->flags & NODE_IN_BLOCK))
+  {
+    t->heap_nodes--;
+    free(node);
+    return;
+  }
+
+  node->left = NULL;
+  node->right = t->free_nodes;
+  if (t->free_nodes != NULL)
+    t->free_nodes->left = node;
+  t->free_nodes = node;
+
+  node_block_t *block = (node_block_t *)((uintptr_t)node & ~(uintptr_t)(NODE_BLOCK_BYTES - 1));
+  if (--block->live > 0)
+    return;
+
+  // 재사용 목록은 양방향(left/right)이므로 블록의 노드를 하나씩 O(1)에 빼낼 수 있다.
+  for (size_t i = 0; i < NODE_BLOCK_NODES; i++)
+    unlink_free_node(t, &block->nodes[i]);
+  if (block->prev != NULL)
+    block->prev->next = block->next;
+  else
+    t->blocks = block->next;
+  if (block->next != NULL)
+    block->next->prev = block->prev;
+  free(block);
+}
+
+// 재사용 목록에서 `node`를 빼는 함수
+void unlink_free_node(rbtree *t, node_t *node)
+{
+  if (node->left != NULL)
+    node->left->right = node->right;
+  else
+    t->free_nodes = node->right;
+  if (node->right != NULL)
+    node->right->left = node->left;
 }
 
 /* 3️⃣ key 추가 */
@@ -56,13 +339,20 @@ void traverse_and_delete_node(rbtree *t, node_t *node)
 node_t *rbtree_insert(rbtree *t, const key_t key)
 {
   // 새 노드 생성
-  node_t *new_node = (node_t *)calloc(1, sizeof(node_t));
+  node_t *new_node = alloc_node(t);
   new_node->key = key;
+  return attach_node(t, new_node, t->root);
+}
+
+// `current`부터 내려가며 새 노드를 삽입할 위치를 찾아 연결하고 불균형을 복구하는 함수
+// `current`는 root이거나, 새 key가 들어갈 자리를 반드시 포함하는 서브트리의 루트여야 한다.
+node_t *attach_node(rbtree *t, node_t *new_node, node_t *current)
+{
+  const key_t key = new_node->key;
   new_node->color = RBTREE_RED;              // 항상 레드로 추가
   new_node->left = new_node->right = t->nil; // 추가한 노드의 자식들을 nil 노드로 설정
 
   // 새 노드를 삽입할 위치 탐색
-  node_t *current = t->root;
   while (current != t->nil)
   {
     if (key < current->key)
@@ -91,12 +381,181 @@ node_t *rbtree_insert(rbtree *t, const key_t key)
   if (current == t->nil)
     t->root = new_node;
 
-  // 불균형 복구
-  rbtree_insert_fixup(t, new_node);
+  // 불균형 복구 (회전은 자식의 서브트리 비트로 다시 계산하므로 먼저 삽입 경로의 비트를 갱신)
+  new_node->rank = 1;
+  update_subtree_flags_upward(t, current);
+  rebalance_after_insert(t, new_node);
+  t->size++;
+  if (t->index != NULL)
+    hash_index_insert(t, new_node);
 
   return new_node;
 }
 
+/* 3️⃣ key 추가 - 여러 key를 한 번에 */
+// 정렬되지 않은 `keys` `n`개를 추가하는 함수
+// 노드는 재사용 목록에서 먼저 꺼내고 모자란 만큼만 블록으로 할당하며 (남은 수가 적으면 노드마다 할당), key를 정렬한 뒤 직전에 삽입한 노드(finger)에서부터 위치를 찾는다.
+// 추가할 key가 기존 노드 수 이상이면 기존 노드와 합쳐 균형 잡힌 트리를 새로 구성한다. (기존 노드 포인터는 유효)
+int rbtree_insert_batch(rbtree *t, const key_t *keys, const size_t n)
+{
+  if (n == 0)
+    return 0;
+
+  key_t *sorted = (key_t *)malloc(n * sizeof(key_t));
+  memcpy(sorted, keys, n * sizeof(key_t));
+  qsort(sorted, n, sizeof(key_t), compare_key);
+
+  node_t **new_nodes = (node_t **)malloc(n * sizeof(node_t *));
+  for (size_t i = 0; i < n; i++)
+  {
+    if (t->free_nodes != NULL || n - i >= NODE_BLOCK_MIN_BATCH)
+      new_nodes[i] = alloc_block_node(t);
+    else
+      new_nodes[i] = alloc_node(t);
+    new_nodes[i]->key = sorted[i];
+  }
+  free(sorted);
+
+  if (n >= t->size)
+  {
+    rebuild_with_nodes(t, new_nodes, n);
+    for (size_t i = 0; t->index != NULL && i < n; i++)
+      hash_index_insert(t, new_nodes[i]);
+    free(new_nodes);
+    return 0;
+  }
+
+  node_t *finger = t->root;
+  for (size_t i = 0; i < n; i++)
+  {
+    attach_node(t, new_nodes[i], find_finger_start(t, finger, new_nodes[i]->key));
+    finger = new_nodes[i];
+  }
+  free(new_nodes);
+  return 0;
+}
+
+// 직전에 삽입한 노드 `finger`에서 올라가며 `key`(>= finger의 key)가 들어갈 서브트리의 루트를 찾는 함수
+// 왼쪽 자식으로 올라온 부모의 key가 `key`보다 크면, 그 아래 서브트리에 `key`의 자리가 있다.
+node_t *find_finger_start(rbtree *t, node_t *finger, const key_t key)
+{
+  node_t *current = finger;
+  while (current != t->root)
+  {
+    node_t *parent = current->parent;
+    if (parent->left == current && key < parent->key)
+      break;
+    current = parent;
+  }
+  return current;
+}
+
+// 기존 노드와 정렬된 새 노드 `n`개를 합쳐 균형 잡힌 트리로 다시 연결하는 함수
+// 노드를 새로 만들지 않고 연결만 바꾸므로 O(size + n)이다.
+void rebuild_with_nodes(rbtree *t, node_t **new_nodes, const size_t n)
+{
+  size_t total = t->size + n;
+  node_t **nodes = (node_t **)malloc((total + t->dead + 1) * sizeof(node_t *));
+  node_t **dead_nodes = nodes + total; // 삭제 표시된 노드는 배열 뒤쪽에 모아두었다가 마지막에 반환
+
+  // 기존 노드(inorder)와 새 노드를 병합
+  node_t *current = t->root;
+  if (current != t->nil)
+    while (current->left != t->nil)
+      current = current->left;
+
+  size_t count = 0, i = 0, dead_count = 0;
+  while (current != t->nil || i < n)
+  {
+    if (current != t->nil && (current->flags & NODE_DEAD))
+    {
+      // 순회 중에는 부모 포인터를 따라 올라가므로 삭제 표시된 노드를 바로 반환할 수 없다.
+      dead_nodes[dead_count++] = current;
+      current = get_next_node(t, current);
+      continue;
+    }
+    if (current != t->nil && (i == n || current->key <= new_nodes[i]->key))
+    {
+      nodes[count++] = current;
+      current = get_next_node(t, current);
+    }
+    else
+      nodes[count++] = new_nodes[i++];
+  }
+  for (size_t j = 0; j < dead_count; j++)
+    release_node(t, dead_nodes[j]);
+  t->dead = 0;
+
+  // 마지막 층(깊이 floor(log2(total)))만 RED로 칠하면 모든 경로의 BLACK 개수가 같아진다.
+  int red_depth = 0;
+  while (((size_t)2 << red_depth) <= total)
+    red_depth++;
+
+  t->root = build_balanced(t, nodes, 0, total, t->nil, 0, red_depth);
+  t->root->color = RBTREE_BLACK; // 트리가 비어있으면 nil 노드 (항상 BLACK)
+  t->size = total;
+  free(nodes);
+}
+
+// 정렬된 `nodes[lo, hi)`의 가운데를 루트로 하는 서브트리를 만드는 함수
+node_t *build_balanced(rbtree *t, node_t **nodes, size_t lo, size_t hi, node_t *parent, int depth, int red_depth)
+{
+  if (lo == hi)
+    return t->nil;
+
+  size_t mid = lo + (hi - lo) / 2;
+  node_t *node = nodes[mid];
+  node->parent = parent;
+  node->color = (depth == red_depth) ? RBTREE_RED : RBTREE_BLACK;
+  node->left = build_balanced(t, nodes, lo, mid, node, depth + 1, red_depth);
+  node->right = build_balanced(t, nodes, mid + 1, hi, node, depth + 1, red_depth);
+  // 양쪽 높이 차가 1 이하이므로 높이를 rank로 쓰면 AVL, WAVL 조건도 만족한다.
+  update_height(node);
+  update_subtree_flags(node);
+  return node;
+}
+
+int compare_key(const void *a, const void *b)
+{
+  key_t x = *(const key_t *)a, y = *(const key_t *)b;
+  return (x > y) - (x < y);
+}
+
+// 트리의 균형 유지 방식에 맞는 삽입 후 복구 함수를 호출하는 함수
+void rebalance_after_insert(rbtree *t, node_t *node)
+{
+  switch (t->balance)
+  {
+  case RBTREE_BALANCE_AVL:
+    avl_rebalance(t, node->parent);
+    break;
+  case RBTREE_BALANCE_WAVL:
+    wavl_insert_fixup(t, node);
+    break;
+  default:
+    rbtree_insert_fixup(t, node);
+  }
+}
+
+// 트리의 균형 유지 방식에 맞는 삭제 후 복구 함수를 호출하는 함수
+// `parent`: 제거된 노드의 부모, `is_left`: 제거된 노드가 왼쪽 자식이었는지 여부
+void rebalance_after_erase(rbtree *t, node_t *parent, int is_left, int is_remove_black)
+{
+  switch (t->balance)
+  {
+  case RBTREE_BALANCE_AVL:
+    avl_rebalance(t, parent);
+    break;
+  case RBTREE_BALANCE_WAVL:
+    wavl_erase_fixup(t, parent, is_left);
+    break;
+  default:
+    /* [CASE D2~D6]: remove 노드가 검정 노드인 경우 */
+    if (is_remove_black)
+      rbtree_erase_fixup(t, parent, is_left);
+  }
+}
+
 // 노드 삽입 후 불균형을 복구하는 함수
 void rbtree_insert_fixup(rbtree *t, node_t *node)
 {
@@ -183,6 +642,8 @@ void right_rotate(rbtree *t, node_t *node)
   node->right = parent;        // 2-2) parent를 노드의 자식으로 변경 (양방향 연결)
   node_right->parent = parent; // 3-1) 노드의 자식의 부모를 parent로 변경
   parent->left = node_right;   // 3-2) 노드의 자식을 부모의 자식으로 변경 (양방향 연결)
+  update_subtree_flags(parent); // 4) 아래로 내려간 parent부터 서브트리 비트 갱신
+  update_subtree_flags(node);
 }
 
 // 왼쪽으로 회전하는 함수
@@ -207,17 +668,35 @@ void left_rotate(rbtree *t, node_t *node)
   node->left = parent;         // 2-2) parent를 노드의 자식으로 변경 (양방향 연결)
   parent->right = node_left;   // 3-1) 노드의 자식의 부모를 parent로 변경
   node_left->parent = parent;  // 3-2) 노드의 자식을 부모의 자식으로 변경 (양방향 연결)
+  update_subtree_flags(parent); // 4) 아래로 내려간 parent부터 서브트리 비트 갱신
+  update_subtree_flags(node);
 }
 
 /* 4️⃣ 탐색 1 - key 탐색 */
 // key에 해당하는 노드를 반환하는 함수
+// 해시 인덱스가 있으면 트리를 내려가지 않고 인덱스에서 바로 찾는다.
 node_t *rbtree_find(const rbtree *t, const key_t key)
 {
-  node_t *current = t->root;
+  if (t->index != NULL)
+    return hash_index_find(t->index, key);
+  return find_in_subtree(t, t->root, key);
+}
+
+// `current`를 루트로 하는 서브트리에서 key에 해당하는 살아있는 노드를 찾는 함수
+node_t *find_in_subtree(const rbtree *t, node_t *current, const key_t key)
+{
   while (current != t->nil)
   {
     if (key == current->key)
-      return current;
+    {
+      if (!(current->flags & NODE_DEAD))
+        return current;
+      // 삭제 표시된 노드: 같은 key는 회전으로 양쪽 서브트리에 모두 있을 수 있으므로 왼쪽도 확인
+      node_t *found = find_in_subtree(t, current->left, key);
+      if (found != NULL)
+        return found;
+      current = current->right;
+    }
     else
       current = (key < current->key) ? current->left : current->right;
   }
@@ -225,36 +704,35 @@ node_t *rbtree_find(const rbtree *t, const key_t key)
 }
 
 /* 4️⃣ 탐색 2 - 최소값을 가진 node 탐색 */
-// key가 최소값에 해당하는 노드를 반환하는 함수
+// key가 최소값에 해당하는 노드를 반환하는 함수 (살아있는 노드가 없으면 NULL 반환)
+// 삭제 표시된 노드만 있는 서브트리는 NODE_NO_LIVE 비트로 건너뛰므로 삭제 표시 노드가 많아도 O(log n)이다.
 node_t *rbtree_min(const rbtree *t)
 {
-  node_t *current = t->root;
-  while (current->left != t->nil)
-    current = current->left;
-  return current;
+  node_t *current = subtree_min_live(t, t->root);
+  return (current != t->nil) ? current : NULL;
 }
 
 /* 4️⃣ 탐색 3 - 최대값을 가진 node 탐색 */
-// key가 최대값에 해당하는 노드를 반환하는 함수
+// key가 최대값에 해당하는 노드를 반환하는 함수 (살아있는 노드가 없으면 NULL 반환)
 node_t *rbtree_max(const rbtree *t)
 {
-  node_t *current = t->root;
-  while (current->right != t->nil)
-    current = current->right;
-  return current;
+  node_t *current = subtree_max_live(t, t->root);
+  return (current != t->nil) ? current : NULL;
 }
 
 /* 5️⃣ array로 변환 */
-// `t`를 inorder로 `n`번 순회한 결과를 `arr`에 담는 함수
+// `t`를 inorder로 `n`번 순회한 결과를 `arr`에 담는 함수 (삭제 표시된 노드는 건너뜀)
 int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n)
 {
   node_t *current = rbtree_min(t);
+  if (current == NULL || n == 0)
+    return 0;
   arr[0] = current->key;
   for (int i = 1; i < n; i++)
   {
     if (current == t->nil)
-      break;                             // 노드가 끝까지 탐색된 경우 loop 탈출
-    current = get_next_node(t, current); // 다음 노드로 이동
+      break;                                  // 노드가 끝까지 탐색된 경우 loop 탈출
+    current = get_next_live_node(t, current); // 다음 노드로 이동
     if (current == t->nil)
       break;               // 노드가 끝까지 탐색된 경우 loop 탈출
     arr[i] = current->key; // 현재 노드의 key 값을 배열에 저장
@@ -264,57 +742,110 @@ int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n)
 
 /* 6️⃣ node 삭제 */
 // 노드를 삭제하는 함수
+// 지연 삭제 모드에서는 삭제 표시만 하고, dead 비율이 기준을 넘은 동안에는 삭제할 때마다 삭제 표시된 노드를
+// LAZY_PURGE_PER_ERASE개씩 실제로 제거한다. (호출 한 번의 작업량은 O(log n)으로 제한)
 int rbtree_erase(rbtree *t, node_t *delete)
 {
-  node_t *remove; // 트리에서 없어질 노드
+  if (t->max_dead_ratio > 0)
+  {
+    if (delete->flags & NODE_DEAD)
+      return 0;
+    delete->flags |= NODE_DEAD;
+    update_subtree_flags_upward(t, delete);
+    if (t->index != NULL)
+      hash_index_remove(t, delete);
+    t->size--;
+    t->dead++;
+    if (t->dead > t->max_dead_ratio * (t->size + t->dead))
+      purge_dead_nodes(t, LAZY_PURGE_PER_ERASE);
+    return 0;
+  }
+
+  if (t->index != NULL)
+    hash_index_remove(t, delete);
+  unlink_node(t, delete);
+  t->size--;
+  return 0;
+}
+
+// `delete` 노드를 트리에서 떼어내 반환하고 불균형을 복구하는 함수 (size, dead는 호출한 쪽에서 갱신)
+// 자식이 둘이면 key를 옮기지 않고 후계자 노드 자체를 delete 자리로 옮기므로, 다른 노드의 포인터는 그대로 유효하다.
+void unlink_node(rbtree *t, node_t *delete)
+{
+  node_t *successor = t->nil;
   node_t *remove_parent, *replace_node;
   int is_remove_black, is_remove_left;
 
-  // Step 1) delete 삭제 후 대체할 replace_node 찾기
-  // Step 1-1) delete 노드의 자식이 둘인 경우: delete의 키를 후계자 노드의 키값으로 대체, 노드의 색은 delete의 색 유지
+  // Step 1) 트리에서 없어질 자리와 그 자리를 대체할 replace_node 찾기
   if (delete->left != t->nil && delete->right != t->nil)
-  {
-    remove = get_next_node(t, delete); // 후계자 노드 (오른쪽 서브트리에서 가장 작은 노드)
-    replace_node = remove->right;      // 대체할 노드: 지워질 노드인 후계자는 항상 왼쪽 자식이 없기 때문에, 자식이 있다면 오른쪽 자식 하나뿐임
-    delete->key = remove->key;         // delete의 키를 후계자 노드의 키값으로 대체 (색은 변경 X)
+  { // Step 1-1) delete 노드의 자식이 둘인 경우: 후계자 노드가 빠진 자리가 없어지고, 후계자는 delete의 자리와 색을 물려받음
+    successor = get_next_node(t, delete); // 후계자 노드 (오른쪽 서브트리에서 가장 작은 노드)
+    replace_node = successor->right;      // 후계자는 항상 왼쪽 자식이 없기 때문에, 자식이 있다면 오른쪽 자식 하나뿐임
+    is_remove_black = successor->color;
+    if (successor->parent == delete)
+    { // 후계자가 delete의 오른쪽 자식이면 후계자가 올라간 뒤 그 오른쪽이 빠진 자리
+      remove_parent = successor;
+      is_remove_left = 0;
+    }
+    else
+    {
+      remove_parent = successor->parent;
+      is_remove_left = 1;
+      remove_parent->left = replace_node;
+      successor->right = delete->right;
+      successor->right->parent = successor;
+    }
+    replace_node->parent = remove_parent;
+
+    // delete 자리에 후계자를 연결 (서브트리 비트는 delete 것을 물려받고 아래에서부터 다시 계산)
+    successor->left = delete->left;
+    successor->left->parent = successor;
+    successor->parent = delete->parent;
+    if (delete == t->root)
+      t->root = successor;
+    else if (delete->parent->left == delete)
+      delete->parent->left = successor;
+    else
+      delete->parent->right = successor;
+    successor->color = delete->color;
+    successor->rank = delete->rank;
+    successor->flags = (successor->flags & ~(NODE_NO_LIVE | NODE_HAS_DEAD)) |
+                       (delete->flags & (NODE_NO_LIVE | NODE_HAS_DEAD));
   }
   else
-  { // Step 1-2) delete 노드의 자식이 없거나 하나인 경우: delete 노드를 자식으로 대체, 노드의 색도 대체되는 노드의 색으로 변경
-    remove = delete;
+  { // Step 1-2) delete 노드의 자식이 없거나 하나인 경우: delete 노드를 자식으로 대체
     // 대체할 노드: 자식이 있으면 자식노드로, 없으면 nil 노드로 대체
-    replace_node = (remove->right != t->nil) ? remove->right : remove->left;
-  }
-  remove_parent = remove->parent;
+    replace_node = (delete->right != t->nil) ? delete->right : delete->left;
+    remove_parent = delete->parent;
 
-  // Step 2) remove 노드 제거하기
-  /* [CASE D1]: remove 노드가 루트인 경우 */
-  if (remove == t->root)
-  {
-    t->root = replace_node;        // 대체할 노드를 트리의 루트로 지정
-    t->root->color = RBTREE_BLACK; // 루트 노드는 항상 BLACK
-    free(remove);
-    return 0; // 불균형 복구 함수 호출 불필요 (제거 전 트리에 노드가 하나 혹은 두개이므로 불균형이 발생하지 않음)
-  }
-
-  // Step 2-1) 'remove의 부모'와 'remove의 자식' 이어주기
-  is_remove_black = remove->color; // remove 노드 제거 전에 지워진 노드의 색 저장
-  is_remove_left = remove_parent->left == remove;
+    /* [CASE D1]: delete 노드가 루트인 경우 */
+    if (delete == t->root)
+    {
+      t->root = replace_node;        // 대체할 노드를 트리의 루트로 지정
+      t->root->color = RBTREE_BLACK; // 루트 노드는 항상 BLACK
+      replace_node->parent = t->nil; // 반환될 delete를 가리키지 않도록 부모를 nil로
+      release_node(t, delete);
+      return; // 불균형 복구 함수 호출 불필요 (제거 전 트리에 노드가 하나 혹은 두개이므로 불균형이 발생하지 않음)
+    }
 
-  // Step 2-1-1) 자식 연결
-  if (is_remove_left) // remove가 왼쪽 자식이었을 경우: remove 부모의 왼쪽에 이어주기
-    remove_parent->left = replace_node;
-  else // remove가 오른쪽 자식이었을 경우: remove 부모의 오른쪽에 이어주기
-    remove_parent->right = replace_node;
+    // Step 1-2-1) 'delete의 부모'와 'delete의 자식' 이어주기 (양방향 연결)
+    is_remove_black = delete->color; // delete 노드 제거 전에 지워진 노드의 색 저장
+    is_remove_left = remove_parent->left == delete;
+    if (is_remove_left)
+      remove_parent->left = replace_node;
+    else
+      remove_parent->right = replace_node;
+    replace_node->parent = remove_parent;
+  }
+  release_node(t, delete);
 
-  // Step 2-1-2) 부모도 연결 (양방향 연결)
-  replace_node->parent = remove_parent;
-  free(remove);
+  // Step 2) 빠진 자리부터 서브트리 비트 갱신 (회전은 자식의 비트로 다시 계산하므로 불균형 복구보다 먼저)
+  update_subtree_flags_upward(t, remove_parent);
+  if (successor != t->nil)
+    update_subtree_flags_upward(t, successor);
 
-  /* [CASE D2~D6]: remove 노드가 검정 노드인 경우 */
   // Step 3) 불균형 복구 함수 호출
-  if (is_remove_black)
-    rbtree_erase_fixup(t, remove_parent, is_remove_left);
-  return 0;
+  rebalance_after_erase(t, remove_parent, is_remove_left, is_remove_black);
 }
 
 // 노드 삭제 후 불균형을 복구하는 함수
@@ -387,6 +918,411 @@ void rbtree_erase_fixup(rbtree *t, node_t *parent, int is_left)
     rbtree_erase_fixup(t, parent->parent, parent->parent->left == parent);
 }
 
+/* 7️⃣ 지연 삭제 */
+// 지연 삭제 모드를 켜고 끄는 함수
+// `max_dead_ratio`가 0보다 크면 rbtree_erase는 노드에 삭제 표시만 하고, 전체 노드 중 삭제 표시된 노드의 비율이
+// `max_dead_ratio`를 넘은 동안에는 삭제할 때마다 삭제 표시된 노드를 몇 개씩 실제로 제거한다. (1 이상이면 자동 정리 없음)
+// 0이면 남아있는 삭제 표시 노드를 정리하고 즉시 삭제 모드로 돌아간다.
+void rbtree_set_lazy_erase(rbtree *t, const double max_dead_ratio)
+{
+  if (max_dead_ratio <= 0 && t->dead > 0)
+    rbtree_compact(t);
+  t->max_dead_ratio = max_dead_ratio > 0 ? max_dead_ratio : 0;
+}
+
+// 삭제 표시된 노드를 모두 반환하고 남은 노드로 균형 잡힌 트리를 다시 구성하는 함수 (O(n))
+// 자동 정리는 호출마다 조금씩만 하므로, 한 번에 비우고 싶을 때 직접 호출한다. 살아있는 노드의 포인터는 그대로 유효하다.
+int rbtree_compact(rbtree *t)
+{
+  rebuild_with_nodes(t, NULL, 0);
+  return 0;
+}
+
+// 삭제 표시된 노드를 최대 `max_nodes`개 트리에서 떼어내 반환하는 함수 (노드마다 O(log n))
+void purge_dead_nodes(rbtree *t, size_t max_nodes)
+{
+  while (max_nodes-- > 0)
+  {
+    node_t *dead = find_dead_node(t);
+    if (dead == t->nil)
+      return;
+    unlink_node(t, dead);
+    t->dead--;
+  }
+}
+
+// NODE_HAS_DEAD 비트를 따라 내려가 삭제 표시된 노드 하나를 찾는 함수 (없으면 nil 노드)
+node_t *find_dead_node(const rbtree *t)
+{
+  node_t *current = t->root;
+  if (!(current->flags & NODE_HAS_DEAD))
+    return t->nil;
+  while (!(current->flags & NODE_DEAD))
+    current = (current->left->flags & NODE_HAS_DEAD) ? current->left : current->right;
+  return current;
+}
+
+// `node`의 NODE_NO_LIVE, NODE_HAS_DEAD 비트를 자신과 두 자식으로부터 다시 계산하는 함수
+void update_subtree_flags(node_t *node)
+{
+  unsigned int flags = node->flags & ~(NODE_NO_LIVE | NODE_HAS_DEAD);
+  if (flags & NODE_DEAD)
+    flags |= NODE_HAS_DEAD | (node->left->flags & node->right->flags & NODE_NO_LIVE);
+  else
+    flags |= (node->left->flags | node->right->flags) & NODE_HAS_DEAD;
+  node->flags = flags;
+}
+
+// `node`부터 루트까지 올라가며 서브트리 비트를 갱신하는 함수
+// 비트가 이전과 같아지면 그 위는 영향이 없으므로 멈춘다. (avl_rebalance와 같은 방식)
+void update_subtree_flags_upward(rbtree *t, node_t *node)
+{
+  while (node != t->nil)
+  {
+    unsigned int old_flags = node->flags;
+    update_subtree_flags(node);
+    if (node->flags == old_flags)
+      return;
+    node = node->parent;
+  }
+}
+
+/* 8️⃣ 해시 인덱스 */
+// key -> node 해시 인덱스를 만들어 rbtree_find가 O(1)로 동작하게 하는 함수
+// 이후 insert/erase가 인덱스를 함께 갱신하고, min/max/rbtree_to_array는 그대로 트리를 사용한다.
+// 같은 key의 노드가 여럿이면 그중 하나만 저장하므로 중복 key가 많아도 탐사 경로가 길어지지 않는다.
+int rbtree_enable_hash_index(rbtree *t)
+{
+  if (t->index != NULL)
+    return 0;
+
+  t->index = (hash_index_t *)calloc(1, sizeof(hash_index_t));
+  // 적재율이 1/2 이하가 되는 크기로 시작
+  int bits = 4;
+  while (((size_t)1 << bits) < t->size * 2)
+    bits++;
+  hash_index_resize(t->index, bits);
+
+  node_t *current = rbtree_min(t);
+  while (current != NULL && current != t->nil)
+  {
+    hash_index_insert(t, current);
+    current = get_next_live_node(t, current);
+  }
+  return 0;
+}
+
+// 해시 인덱스를 제거하는 함수
+void rbtree_disable_hash_index(rbtree *t)
+{
+  if (t->index == NULL)
+    return;
+  free(t->index->slots);
+  free(t->index);
+  t->index = NULL;
+}
+
+// key가 처음 놓일 slot 번호 (fibonacci hashing: 곱셈 결과의 상위 bits 비트)
+size_t hash_home(const hash_index_t *index, const key_t key)
+{
+  return (size_t)(((uint64_t)(uint32_t)key * 0x9E3779B97F4A7C15ull) >> (64 - index->bits));
+}
+
+// slot 개수를 2^bits로 바꾸고 기존 항목을 다시 배치하는 함수
+void hash_index_resize(hash_index_t *index, int bits)
+{
+  hash_slot_t *old_slots = index->slots;
+  size_t old_capacity = old_slots ? (size_t)1 << index->bits : 0;
+
+  index->bits = bits;
+  index->slots = (hash_slot_t *)calloc((size_t)1 << bits, sizeof(hash_slot_t));
+  size_t mask = ((size_t)1 << bits) - 1;
+  for (size_t i = 0; i < old_capacity; i++)
+  {
+    if (old_slots[i].node == NULL)
+      continue;
+    size_t j = hash_home(index, old_slots[i].key);
+    while (index->slots[j].node != NULL)
+      j = (j + 1) & mask;
+    index->slots[j] = old_slots[i];
+  }
+  free(old_slots);
+}
+
+// 노드를 인덱스에 추가하는 함수 (선형 탐사, 적재율이 1/2을 넘으면 두 배로 확장)
+// 같은 key가 이미 있으면 그 slot이 계속 대표 노드를 가리키므로 아무것도 하지 않는다.
+void hash_index_insert(rbtree *t, node_t *node)
+{
+  hash_index_t *index = t->index;
+  if (hash_index_slot(index, node->key) != NULL)
+    return;
+  if ((index->count + 1) * 2 > ((size_t)1 << index->bits))
+    hash_index_resize(index, index->bits + 1);
+
+  size_t mask = ((size_t)1 << index->bits) - 1;
+  size_t i = hash_home(index, node->key);
+  while (index->slots[i].node != NULL)
+    i = (i + 1) & mask;
+  index->slots[i].key = node->key;
+  index->slots[i].node = node;
+  index->count++;
+}
+
+// 트리에서 빠질 노드를 인덱스에서 제거하는 함수 (노드가 아직 트리에 연결되어 있을 때 호출)
+// 대표 노드가 빠지면 같은 key의 이웃 노드로 바꾸고, 이웃이 없을 때만 slot을 비운다.
+// 삭제 표시(tombstone) 대신 뒤쪽 항목을 당겨와 탐사 경로가 끊기지 않게 한다. (backward shift deletion)
+void hash_index_remove(rbtree *t, node_t *node)
+{
+  hash_index_t *index = t->index;
+  hash_slot_t *slot = hash_index_slot(index, node->key);
+  if (slot == NULL || slot->node != node)
+    return;
+  node_t *neighbor = find_equal_live_neighbor(t, node);
+  if (neighbor != NULL)
+  {
+    slot->node = neighbor;
+    return;
+  }
+
+  size_t mask = ((size_t)1 << index->bits) - 1;
+  size_t i = (size_t)(slot - index->slots);
+  size_t j = i;
+  while (1)
+  {
+    j = (j + 1) & mask;
+    if (index->slots[j].node == NULL)
+      break;
+    // j의 항목이 처음 놓일 자리가 (i, j] 밖이면 i로 당겨도 탐사 경로가 유지된다.
+    size_t home = hash_home(index, index->slots[j].key);
+    if (((j - home) & mask) >= ((j - i) & mask))
+    {
+      index->slots[i] = index->slots[j];
+      i = j;
+    }
+  }
+  index->slots[i].node = NULL;
+  index->count--;
+}
+
+// key가 저장된 slot을 찾는 함수 (없으면 NULL)
+hash_slot_t *hash_index_slot(const hash_index_t *index, const key_t key)
+{
+  size_t mask = ((size_t)1 << index->bits) - 1;
+  size_t i = hash_home(index, key);
+  while (index->slots[i].node != NULL)
+  {
+    if (index->slots[i].key == key)
+      return &index->slots[i];
+    i = (i + 1) & mask;
+  }
+  return NULL;
+}
+
+// `node`와 key가 같은 살아있는 노드를 inorder 이웃에서 찾는 함수 (없으면 NULL)
+// 같은 key는 inorder로 이어져 있으므로 양쪽으로 key가 달라질 때까지만 본다.
+node_t *find_equal_live_neighbor(const rbtree *t, node_t *node)
+{
+  for (node_t *p = get_next_node(t, node); p != t->nil && p->key == node->key; p = get_next_node(t, p))
+    if (!(p->flags & NODE_DEAD))
+      return p;
+  for (node_t *p = get_prev_node(t, node); p != t->nil && p->key == node->key; p = get_prev_node(t, p))
+    if (!(p->flags & NODE_DEAD))
+      return p;
+  return NULL;
+}
+
+// key에 해당하는 노드를 인덱스에서 찾는 함수 (없으면 NULL)
+node_t *hash_index_find(const hash_index_t *index, const key_t key)
+{
+  hash_slot_t *slot = hash_index_slot(index, key);
+  return slot != NULL ? slot->node : NULL;
+}
+
+/* 9️⃣ AVL */
+// `node`부터 루트까지 올라가며 높이를 갱신하고 높이 차가 2가 된 노드를 회전하는 함수
+// 서브트리 높이가 이전과 같아지면 그 위는 영향이 없으므로 멈춘다. (삽입, 삭제 공통)
+void avl_rebalance(rbtree *t, node_t *node)
+{
+  while (node != t->nil)
+  {
+    int old_height = node->rank;
+    node = avl_fix_node(t, node);
+    if (node->rank == old_height)
+      return;
+    node = node->parent;
+  }
+}
+
+// `node`의 높이를 갱신하고 필요하면 회전한 뒤, 그 자리의 새 서브트리 루트를 반환하는 함수
+node_t *avl_fix_node(rbtree *t, node_t *node)
+{
+  int diff = (int)node->left->rank - (int)node->right->rank;
+  if (diff > 1)
+  {
+    node_t *child = node->left;
+    if (child->right->rank > child->left->rank)
+    { // [LR] 왼쪽 자식의 오른쪽이 더 높으면 먼저 왼쪽으로 회전
+      node_t *grand_child = child->right;
+      left_rotate(t, grand_child);
+      update_height(child);
+      update_height(grand_child);
+      child = grand_child;
+    }
+    // [LL] 오른쪽으로 회전
+    right_rotate(t, child);
+    update_height(node);
+    update_height(child);
+    return child;
+  }
+  if (diff < -1)
+  {
+    node_t *child = node->right;
+    if (child->left->rank > child->right->rank)
+    { // [RL] 오른쪽 자식의 왼쪽이 더 높으면 먼저 오른쪽으로 회전
+      node_t *grand_child = child->left;
+      right_rotate(t, grand_child);
+      update_height(child);
+      update_height(grand_child);
+      child = grand_child;
+    }
+    // [RR] 왼쪽으로 회전
+    left_rotate(t, child);
+    update_height(node);
+    update_height(child);
+    return child;
+  }
+  update_height(node);
+  return node;
+}
+
+void update_height(node_t *node)
+{
+  unsigned int left = node->left->rank, right = node->right->rank;
+  node->rank = 1 + (left > right ? left : right);
+}
+
+/* 🔟 WAVL (weak AVL) */
+// 모든 노드의 rank 차(부모 rank - 자식 rank)는 1 또는 2이고, leaf의 rank는 0이다. (저장값은 rank + 1)
+// 노드 삽입 후 rank 차가 0이 된 곳을 승격(promote) 또는 회전으로 복구하는 함수
+void wavl_insert_fixup(rbtree *t, node_t *node)
+{
+  node_t *parent = node->parent;
+  while (parent != t->nil && parent->rank == node->rank)
+  {
+    int is_left = parent->left == node;
+    node_t *sibling = is_left ? parent->right : parent->left;
+
+    // [CASE W1] 부모가 0,1 노드: 부모를 승격하고 위로 이동
+    if (parent->rank - sibling->rank == 1)
+    {
+      parent->rank++;
+      node = parent;
+      parent = node->parent;
+      continue;
+    }
+
+    // 부모가 0,2 노드: 회전 후 종료
+    node_t *inner = is_left ? node->right : node->left; // 부모 쪽을 향한 자식
+    if (node->rank - inner->rank == 2)
+    { // [CASE W2] 바깥쪽 자식이 1-child: 한 번 회전
+      if (is_left)
+        right_rotate(t, node);
+      else
+        left_rotate(t, node);
+      parent->rank--;
+    }
+    else
+    { // [CASE W3] 안쪽 자식이 1-child: 두 번 회전
+      if (is_left)
+      {
+        left_rotate(t, inner);
+        right_rotate(t, inner);
+      }
+      else
+      {
+        right_rotate(t, inner);
+        left_rotate(t, inner);
+      }
+      inner->rank++;
+      node->rank--;
+      parent->rank--;
+    }
+    return;
+  }
+}
+
+// 노드 삭제 후 rank 차가 3이 된 곳이나 2,2 leaf를 강등(demote) 또는 회전으로 복구하는 함수 (회전은 최대 2번)
+// `parent`: 제거된 노드의 부모, `is_left`: 제거된 노드 자리가 왼쪽 자식인지 여부
+void wavl_erase_fixup(rbtree *t, node_t *parent, int is_left)
+{
+  node_t *node = is_left ? parent->left : parent->right;
+
+  // [CASE D1] 부모가 자식이 없는데 rank가 1인 2,2 leaf가 된 경우: 강등
+  if (parent->left == t->nil && parent->right == t->nil && parent->rank == 2)
+  {
+    parent->rank = 1;
+    node = parent;
+    parent = node->parent;
+    if (parent == t->nil)
+      return;
+    is_left = parent->left == node;
+  }
+
+  node_t *sibling;
+  while (parent != t->nil && parent->rank - node->rank == 3)
+  {
+    sibling = is_left ? parent->right : parent->left;
+    if (parent->rank - sibling->rank == 2)
+      parent->rank--; // [CASE D2] 형제가 2-child: 부모 강등
+    else if (sibling->rank - sibling->left->rank == 2 && sibling->rank - sibling->right->rank == 2)
+    { // [CASE D3] 형제가 2,2 노드: 부모와 형제 강등
+      parent->rank--;
+      sibling->rank--;
+    }
+    else
+      break; // 회전 필요
+
+    node = parent;
+    parent = node->parent;
+    if (parent == t->nil)
+      return;
+    is_left = parent->left == node;
+  }
+  if (parent == t->nil || parent->rank - node->rank != 3)
+    return;
+
+  // 형제가 1-child이고 2,2 노드가 아닌 경우
+  node_t *outer = is_left ? sibling->right : sibling->left;
+  node_t *inner = is_left ? sibling->left : sibling->right;
+  if (sibling->rank - outer->rank == 1)
+  { // [CASE D4] 형제의 바깥쪽 자식이 1-child: 한 번 회전
+    if (is_left)
+      left_rotate(t, sibling);
+    else
+      right_rotate(t, sibling);
+    sibling->rank++;
+    parent->rank--;
+    if (parent->left == t->nil && parent->right == t->nil)
+      parent->rank--; // leaf는 2,2가 될 수 없으므로 한 번 더 강등
+    return;
+  }
+
+  // [CASE D5] 형제의 안쪽 자식이 1-child: 두 번 회전
+  if (is_left)
+  {
+    right_rotate(t, inner);
+    left_rotate(t, inner);
+  }
+  else
+  {
+    left_rotate(t, inner);
+    right_rotate(t, inner);
+  }
+  inner->rank += 2;
+  sibling->rank--;
+  parent->rank -= 2;
+}
+
 void exchange_color(node_t *a, node_t *b)
 {
   int tmp = a->color;
@@ -412,4 +1348,77 @@ node_t *get_next_node(const rbtree *t, node_t *p)
   while (current->left != t->nil) // 왼쪽 자식이 있으면
     current = current->left;      // 왼쪽 끝으로 이동
   return current;
-}
\ No newline at end of file
+}
+
+// 키 값을 기준으로 이전 노드를 반환하는 함수 (get_next_node의 좌우 대칭)
+node_t *get_prev_node(const rbtree *t, node_t *p)
+{
+  node_t *current = p->left;
+  if (current == t->nil)
+  {
+    current = p;
+    while (current->parent != t->nil && current->parent->left == current)
+      current = current->parent;
+    return current->parent;
+  }
+  while (current->right != t->nil)
+    current = current->right;
+  return current;
+}
+
+// 삭제 표시되지 않은 다음 노드를 반환하는 함수 (없으면 nil 노드)
+// 올라가는 동안 살아있는 노드가 없는 오른쪽 서브트리는 들어가지 않으므로 O(log n)이다.
+node_t *get_next_live_node(const rbtree *t, node_t *p)
+{
+  node_t *current = subtree_min_live(t, p->right);
+  if (current != t->nil)
+    return current;
+
+  current = p;
+  while (current->parent != t->nil)
+  {
+    node_t *parent = current->parent;
+    if (parent->left == current)
+    { // 왼쪽 서브트리에서 올라온 경우: 부모, 부모의 오른쪽 서브트리 순으로 확인
+      if (!(parent->flags & NODE_DEAD))
+        return parent;
+      node_t *found = subtree_min_live(t, parent->right);
+      if (found != t->nil)
+        return found;
+    }
+    current = parent;
+  }
+  return t->nil;
+}
+
+// `node`를 루트로 하는 서브트리에서 key가 가장 작은 살아있는 노드를 반환하는 함수 (없으면 nil 노드)
+node_t *subtree_min_live(const rbtree *t, node_t *node)
+{
+  if (node->flags & NODE_NO_LIVE)
+    return t->nil;
+  while (1)
+  {
+    if (!(node->left->flags & NODE_NO_LIVE))
+      node = node->left;
+    else if (!(node->flags & NODE_DEAD))
+      return node;
+    else
+      node = node->right; // 자신과 왼쪽이 모두 삭제 표시되었으면 살아있는 노드는 오른쪽에 있다.
+  }
+}
+
+// `node`를 루트로 하는 서브트리에서 key가 가장 큰 살아있는 노드를 반환하는 함수 (subtree_min_live의 좌우 대칭)
+node_t *subtree_max_live(const rbtree *t, node_t *node)
+{
+  if (node->flags & NODE_NO_LIVE)
+    return t->nil;
+  while (1)
+  {
+    if (!(node->right->flags & NODE_NO_LIVE))
+      node = node->right;
+    else if (!(node->flags & NODE_DEAD))
+      return node;
+    else
+      node = node->left;
+  }
+}
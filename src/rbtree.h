@@ -5,27 +5,61 @@
 
 typedef enum { RBTREE_RED, RBTREE_BLACK } color_t;
 
+// 균형 유지 방식: red-black, AVL, weak AVL (rank-balanced)
+typedef enum { RBTREE_BALANCE_RB, RBTREE_BALANCE_AVL, RBTREE_BALANCE_WAVL } balance_t;
+
+// new_rbtree가 사용하는 균형 유지 방식 (빌드 시 -DRBTREE_DEFAULT_BALANCE=RBTREE_BALANCE_AVL 등으로 변경)
+#ifndef RBTREE_DEFAULT_BALANCE
+#define RBTREE_DEFAULT_BALANCE RBTREE_BALANCE_RB
+#endif
+
 typedef int key_t;
 
+#define NODE_IN_BLOCK 0x1  // rbtree_insert_batch가 한 번에 할당한 블록에 속한 노드
+#define NODE_DEAD 0x2      // 지연 삭제 모드에서 삭제 표시만 된 노드 (점진 정리나 compaction 때 제거)
+#define NODE_NO_LIVE 0x4   // 서브트리에 살아있는 노드가 없음 (nil 노드는 항상 설정, min/max/순회가 건너뜀)
+#define NODE_HAS_DEAD 0x8  // 서브트리에 삭제 표시된 노드가 있음 (점진 정리가 정리할 노드를 찾아 내려감)
+
 typedef struct node_t {
-  color_t color;
+  color_t color : 8;
+  unsigned int flags : 8;  // NODE_* 비트 (color와 같은 4바이트에 담아 노드 크기를 32바이트로 유지)
+  unsigned int rank : 8;   // AVL: 서브트리 높이, WAVL: rank + 1 (두 방식 모두 nil은 0, leaf는 1)
   key_t key;
   struct node_t *parent, *left, *right;
 } node_t;
 
+typedef struct node_block_t node_block_t;
+typedef struct hash_index_t hash_index_t;
+
 typedef struct {
   node_t *root;
   node_t *nil;  // for sentinel
+  size_t size;  // 살아있는 노드 개수
+  size_t dead;  // 삭제 표시만 되고 아직 트리에 남아있는 노드 개수
+  double max_dead_ratio;  // 0보다 크면 지연 삭제 모드: dead 비율이 이 값을 넘으면 삭제할 때마다 몇 개씩 정리
+  node_block_t *blocks;  // rbtree_insert_batch가 할당한 노드 블록 목록 (노드가 모두 반환된 블록은 바로 반환)
+  node_t *free_nodes;    // 블록에 속한 노드 중 트리에 없는 재사용 대기 노드 (left/right로 양방향 연결)
+  size_t heap_nodes;     // 블록이 아니라 노드마다 따로 할당되어 트리에 있는 노드 개수
+  hash_index_t *index;   // key -> node 해시 인덱스 (NULL이면 사용하지 않음)
+  balance_t balance;
 } rbtree;
 
 rbtree *new_rbtree(void);
+rbtree *new_rbtree_with_balance(const balance_t);
 void delete_rbtree(rbtree *);
+void rbtree_delete_async(rbtree *);
+void rbtree_reclaim_wait(void);
 
 node_t *rbtree_insert(rbtree *, const key_t);
+int rbtree_insert_batch(rbtree *, const key_t *, const size_t);
 node_t *rbtree_find(const rbtree *, const key_t);
 node_t *rbtree_min(const rbtree *);
 node_t *rbtree_max(const rbtree *);
 int rbtree_erase(rbtree *, node_t *);
+void rbtree_set_lazy_erase(rbtree *, const double);
+int rbtree_compact(rbtree *);
+int rbtree_enable_hash_index(rbtree *);
+void rbtree_disable_hash_index(rbtree *);
 
 int rbtree_to_array(const rbtree *, key_t *, const size_t);
 
@@ -0,0 +1,332 @@
+#include "rbtree_str.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define STR_ARENA_BLOCK_SIZE 4096
+
+// rbtree.c의 균형 복구 함수들을 그대로 재사용한다. (str_node_t는 node_t로 시작하므로 형변환만 하면 된다.)
+void traverse_and_delete_node(rbtree *t, node_t *node);
+void rbtree_insert_fixup(rbtree *t, node_t *node);
+void rbtree_erase_fixup(rbtree *t, node_t *parent, int is_left);
+node_t *get_next_node(const rbtree *t, node_t *p);
+
+uint64_t make_prefix(const char *key, size_t len);
+int compare_str_key(uint64_t prefix, const char *key, size_t len, const str_node_t *node, size_t common_len);
+void shrink_common(str_rbtree *t, const char *key, size_t len);
+void refresh_prefix(str_node_t *node, size_t common_len);
+const char *arena_copy(str_rbtree *t, const char *key, size_t len);
+void free_arena(str_arena_t *block);
+
+struct str_arena_t
+{
+  struct str_arena_t *next;
+  size_t used, cap;
+  char data[];
+};
+
+/* 1️⃣ 문자열 key RB tree 구조체 생성 */
+str_rbtree *new_str_rbtree(void)
+{
+  str_rbtree *t = (str_rbtree *)calloc(1, sizeof(str_rbtree));
+
+  // nil 노드는 색과 부모 포인터만 쓰이므로 node_t 크기면 충분하다.
+  node_t *nil = (node_t *)calloc(1, sizeof(node_t));
+  nil->color = RBTREE_BLACK;
+  t->tree.nil = t->tree.root = nil;
+
+  return t;
+}
+
+/* 2️⃣ 문자열 key RB tree 구조체가 차지했던 메모리 반환 */
+void delete_str_rbtree(str_rbtree *t)
+{
+  if (t->tree.root != t->tree.nil)
+    traverse_and_delete_node(&t->tree, t->tree.root);
+  free(t->tree.nil);
+
+  // key 바이트는 arena 블록 단위로 한꺼번에 반환
+  free_arena(t->arena);
+  free(t);
+}
+
+/* 3️⃣ key 추가 */
+str_node_t *str_rbtree_insert(str_rbtree *t, const char *key, const size_t len)
+{
+  node_t *nil = t->tree.nil;
+  str_node_t *new_node = (str_node_t *)calloc(1, sizeof(str_node_t));
+  new_node->len = (uint32_t)len;
+  new_node->key = arena_copy(t, key, len);
+
+  // 공통 접두사를 새 key와 공유하는 길이로 줄인 뒤, 그 다음 8바이트를 prefix로 쓴다.
+  if (t->common == NULL)
+  {
+    t->common = new_node->key;
+    t->common_len = len;
+  }
+  else
+    shrink_common(t, key, len);
+  refresh_prefix(new_node, t->common_len);
+  new_node->link.color = RBTREE_RED;
+  new_node->link.left = new_node->link.right = nil;
+
+  // 삽입 위치 탐색: 같은 key는 오른쪽으로 (rbtree_insert와 동일)
+  node_t *current = t->tree.root;
+  while (current != nil)
+  {
+    // common_len이 줄어든 뒤 아직 갱신되지 않은 노드는 지나가는 김에 prefix를 다시 계산한다.
+    if (((str_node_t *)current)->prefix_at != t->common_len)
+      refresh_prefix((str_node_t *)current, t->common_len);
+
+    node_t **child;
+    if (compare_str_key(new_node->prefix, key, len, (str_node_t *)current, t->common_len) < 0)
+      child = &current->left;
+    else
+      child = &current->right;
+
+    if (*child == nil)
+    {
+      *child = &new_node->link;
+      break;
+    }
+    current = *child;
+  }
+
+  new_node->link.parent = current;
+  if (current == nil)
+    t->tree.root = &new_node->link;
+
+  rbtree_insert_fixup(&t->tree, &new_node->link);
+  t->tree.size++;
+  return new_node;
+}
+
+/* 4️⃣ 탐색 1 - key 탐색 */
+str_node_t *str_rbtree_find(const str_rbtree *t, const char *key, const size_t len)
+{
+  // 공통 접두사가 다르면 tree의 어떤 key와도 같을 수 없다.
+  size_t common_len = t->common_len;
+  if (t->common == NULL || len < common_len || memcmp(key, t->common, common_len) != 0)
+    return NULL;
+
+  uint64_t prefix = make_prefix(key + common_len, len - common_len);
+  node_t *current = t->tree.root;
+  while (current != t->tree.nil)
+  {
+    int cmp = compare_str_key(prefix, key, len, (str_node_t *)current, common_len);
+    if (cmp == 0)
+      return (str_node_t *)current;
+    current = (cmp < 0) ? current->left : current->right;
+  }
+  return NULL;
+}
+
+/* 4️⃣ 탐색 2 - 최소값을 가진 node 탐색 */
+// 트리가 비어있으면 NULL 반환
+str_node_t *str_rbtree_min(const str_rbtree *t)
+{
+  node_t *current = t->tree.root;
+  if (current == t->tree.nil)
+    return NULL;
+  while (current->left != t->tree.nil)
+    current = current->left;
+  return (str_node_t *)current;
+}
+
+/* 4️⃣ 탐색 3 - 최대값을 가진 node 탐색 */
+// 트리가 비어있으면 NULL 반환
+str_node_t *str_rbtree_max(const str_rbtree *t)
+{
+  node_t *current = t->tree.root;
+  if (current == t->tree.nil)
+    return NULL;
+  while (current->right != t->tree.nil)
+    current = current->right;
+  return (str_node_t *)current;
+}
+
+/* 5️⃣ array로 변환 */
+// inorder 순서로 최대 `n`개의 key 포인터를 `arr`에 담는 함수 (포인터는 다음 erase/compact 전까지 유효)
+int str_rbtree_to_array(const str_rbtree *t, const char **arr, const size_t n)
+{
+  if (t->tree.root == t->tree.nil)
+    return 0;
+
+  node_t *current = &str_rbtree_min(t)->link;
+  for (size_t i = 0; i < n && current != t->tree.nil; i++)
+  {
+    arr[i] = ((str_node_t *)current)->key;
+    current = get_next_node(&t->tree, current);
+  }
+  return 0;
+}
+
+/* 6️⃣ node 삭제 */
+// rbtree_erase와 같은 방식이지만, 자식이 둘인 경우 key 대신 prefix/len/key를 통째로 옮긴다.
+// 삭제된 key의 바이트가 arena의 절반을 넘으면 살아있는 key만 새 arena로 옮긴다. (분할 상환 O(1))
+int str_rbtree_erase(str_rbtree *t, str_node_t *delete)
+{
+  node_t *nil = t->tree.nil;
+  node_t *remove, *remove_parent, *replace_node;
+  int is_remove_black, is_remove_left;
+
+  t->dead_bytes += delete->len + 1;
+
+  if (delete->link.left != nil && delete->link.right != nil)
+  {
+    remove = get_next_node(&t->tree, &delete->link);
+    replace_node = remove->right;
+    // 후계자의 key 정보를 복사 (key 바이트는 arena에 남아있으므로 포인터만 옮기면 된다)
+    delete->prefix = ((str_node_t *)remove)->prefix;
+    delete->prefix_at = ((str_node_t *)remove)->prefix_at;
+    delete->len = ((str_node_t *)remove)->len;
+    delete->key = ((str_node_t *)remove)->key;
+  }
+  else
+  {
+    remove = &delete->link;
+    replace_node = (remove->right != nil) ? remove->right : remove->left;
+  }
+  remove_parent = remove->parent;
+
+  if (remove == t->tree.root)
+  {
+    t->tree.root = replace_node;
+    t->tree.root->color = RBTREE_BLACK;
+    replace_node->parent = nil;
+    free(remove);
+    if (--t->tree.size == 0)
+    {
+      // 다음 key부터 공통 접두사를 새로 잡고, 모든 key가 삭제됐으므로 arena도 비운다.
+      t->common = NULL;
+      str_rbtree_compact(t);
+    }
+    return 0;
+  }
+
+  is_remove_black = remove->color;
+  is_remove_left = remove_parent->left == remove;
+
+  if (is_remove_left)
+    remove_parent->left = replace_node;
+  else
+    remove_parent->right = replace_node;
+  replace_node->parent = remove_parent;
+  free(remove);
+  t->tree.size--;
+
+  if (is_remove_black)
+    rbtree_erase_fixup(&t->tree, remove_parent, is_remove_left);
+  if (t->dead_bytes > STR_ARENA_BLOCK_SIZE && t->dead_bytes * 2 > t->arena_bytes)
+    str_rbtree_compact(t);
+  return 0;
+}
+
+/* 7️⃣ arena 정리 */
+// 살아있는 key만 새 arena에 inorder 순서로 옮기고 이전 arena를 반환하는 함수 (O(n))
+// 옮기는 김에 모든 노드의 prefix를 지금의 common_len 기준으로 다시 계산한다.
+void str_rbtree_compact(str_rbtree *t)
+{
+  str_arena_t *old = t->arena;
+  t->arena = NULL;
+  t->arena_bytes = t->dead_bytes = 0;
+
+  node_t *nil = t->tree.nil;
+  str_node_t *min = str_rbtree_min(t);
+  for (node_t *current = min ? &min->link : nil; current != nil; current = get_next_node(&t->tree, current))
+  {
+    str_node_t *node = (str_node_t *)current;
+    node->key = arena_copy(t, node->key, node->len);
+    refresh_prefix(node, t->common_len);
+  }
+  if (min != NULL)
+    t->common = min->key; // 어느 key든 공통 접두사를 담고 있다.
+  free_arena(old);
+}
+
+// key 앞 8바이트를 big-endian 정수로 만드는 함수
+// 정수 비교 결과가 앞 8바이트의 memcmp 결과와 같아진다. (호출하는 쪽에서 공통 접두사만큼 건너뛴 key를 넘긴다.)
+uint64_t make_prefix(const char *key, size_t len)
+{
+  uint64_t prefix = 0;
+  size_t n = len < 8 ? len : 8;
+  for (size_t i = 0; i < 8; i++)
+  {
+    prefix <<= 8;
+    if (i < n)
+      prefix |= (unsigned char)key[i];
+  }
+  return prefix;
+}
+
+// (prefix, key, len)을 노드의 key와 비교하는 함수
+// 두 key 모두 앞 `common_len` 바이트가 tree의 공통 접두사와 같아야 한다.
+// prefix가 다르면 노드의 key를 읽지 않고 결정되고, 같을 때만 arena의 key 나머지를 비교한다.
+// 노드의 prefix가 이전 common_len 기준이면 prefix를 쓰지 않고 key를 바로 비교한다.
+int compare_str_key(uint64_t prefix, const char *key, size_t len, const str_node_t *node, size_t common_len)
+{
+  int fresh = node->prefix_at == common_len;
+  if (fresh && prefix != node->prefix)
+    return prefix < node->prefix ? -1 : 1;
+
+  size_t min_len = len < node->len ? len : node->len;
+  // 공통 접두사와 (prefix가 같고 둘 다 8바이트 이상 남았다면) 그 다음 8바이트는 이미 같음이 확인됐다.
+  size_t skip = common_len + (fresh && min_len - common_len >= 8 ? 8 : 0);
+  int cmp = memcmp(key + skip, node->key + skip, min_len - skip);
+  if (cmp != 0)
+    return cmp;
+  if (len == node->len)
+    return 0;
+  return len < node->len ? -1 : 1;
+}
+
+// 공통 접두사를 `key`와 공유하는 길이로 줄이는 함수
+// 노드의 prefix는 여기서 다시 계산하지 않는다. (prefix_at이 달라진 노드는 필요할 때 갱신된다.)
+void shrink_common(str_rbtree *t, const char *key, size_t len)
+{
+  size_t common_len = t->common_len < len ? t->common_len : len;
+  size_t i = 0;
+  while (i < common_len && key[i] == t->common[i])
+    i++;
+  t->common_len = i;
+}
+
+// 노드의 prefix를 `common_len` 다음 8바이트로 다시 계산하는 함수
+void refresh_prefix(str_node_t *node, size_t common_len)
+{
+  node->prefix = make_prefix(node->key + common_len, node->len - common_len);
+  node->prefix_at = (uint32_t)common_len;
+}
+
+// key 바이트를 tree의 arena에 복사하는 함수
+// C 문자열로도 쓸 수 있도록 끝에 '\0'을 붙여 저장한다.
+const char *arena_copy(str_rbtree *t, const char *key, size_t len)
+{
+  str_arena_t *block = t->arena;
+  if (block == NULL || block->cap - block->used < len + 1)
+  {
+    // 새 블록 할당 (key가 기본 블록보다 크면 key 크기만큼)
+    size_t cap = len + 1 > STR_ARENA_BLOCK_SIZE ? len + 1 : STR_ARENA_BLOCK_SIZE;
+    block = (str_arena_t *)malloc(sizeof(str_arena_t) + cap);
+    block->used = 0;
+    block->cap = cap;
+    block->next = t->arena;
+    t->arena = block;
+  }
+
+  char *dest = block->data + block->used;
+  memcpy(dest, key, len);
+  dest[len] = '\0';
+  block->used += len + 1;
+  t->arena_bytes += len + 1;
+  return dest;
+}
+
+void free_arena(str_arena_t *block)
+{
+  while (block != NULL)
+  {
+    str_arena_t *next = block->next;
+    free(block);
+    block = next;
+  }
+}
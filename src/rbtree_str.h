@@ -0,0 +1,43 @@
+#ifndef _RBTREE_STR_H_
+#define _RBTREE_STR_H_
+
+#include "rbtree.h"
+
+#include <stdint.h>
+
+// 비교 시 포인터를 따라가지 않도록 key의 8바이트와 길이를 노드에 함께 저장한다.
+// 모든 key가 공유하는 앞부분(URL의 "https://" 등)은 비교에 쓸모가 없으므로 그 다음 8바이트를 저장한다.
+typedef struct str_node_t {
+  node_t link;      // 색/부모/자식 포인터 (회전과 fixup은 rbtree.c의 것을 그대로 사용)
+  uint64_t prefix;     // key의 prefix_at 다음 8바이트를 big-endian으로 채운 값 (부족하면 0으로 채움)
+  uint32_t len;
+  uint32_t prefix_at;  // prefix를 계산할 때의 common_len (지금의 common_len과 다르면 prefix를 쓰지 않는다.)
+  const char *key;  // tree의 arena에 복사된 key 전체 ('\0'으로 끝남)
+} str_node_t;
+
+typedef struct str_arena_t str_arena_t;
+
+typedef struct {
+  rbtree tree;
+  str_arena_t *arena;  // key 바이트를 담는 tree 소유 메모리
+  size_t arena_bytes;  // arena에 복사된 key 바이트 ('\0' 포함)
+  size_t dead_bytes;   // 그중 삭제된 key의 바이트 (arena_bytes의 절반을 넘으면 arena를 다시 채운다.)
+  const char *common;  // 공통 접두사를 담은 key (arena 안, tree가 비어있으면 NULL)
+  size_t common_len;   // tree의 모든 key가 공유하는 앞부분의 길이
+  // common_len이 줄어도 노드의 prefix는 바로 다시 계산하지 않는다. (O(1))
+  // 그 전까지 해당 노드와의 비교는 arena의 key를 읽고, insert가 지나가는 노드나 arena 정리 때 새로 계산된다.
+} str_rbtree;
+
+str_rbtree *new_str_rbtree(void);
+void delete_str_rbtree(str_rbtree *);
+
+str_node_t *str_rbtree_insert(str_rbtree *, const char *, const size_t);
+str_node_t *str_rbtree_find(const str_rbtree *, const char *, const size_t);
+str_node_t *str_rbtree_min(const str_rbtree *);
+str_node_t *str_rbtree_max(const str_rbtree *);
+int str_rbtree_erase(str_rbtree *, str_node_t *);
+void str_rbtree_compact(str_rbtree *);
+
+int str_rbtree_to_array(const str_rbtree *, const char **, const size_t);
+
+#endif  // _RBTREE_STR_H_
@@ -0,0 +1,579 @@
+#include "rbtree_wal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WAL_LOG_MAGIC 0x4c574252u  // "RBWL"
+#define WAL_CKPT_MAGIC 0x4b434252u // "RBCK"
+#define WAL_OP_INSERT 1u
+#define WAL_OP_ERASE 2u
+
+// 로그 파일 = wal_header_t + wal_record_t 배열
+// checkpoint 파일 = wal_header_t + uint64_t 개수 + uint64_t 로그 offset + key 배열 + uint32_t checksum
+// (로그 offset: snapshot이 이전 세대 로그를 어디까지 담았는지. 로그 교체 전에 중단되면 그 뒤부터 재실행한다.)
+typedef struct
+{
+  uint32_t magic;
+  uint32_t generation;
+} wal_header_t;
+
+typedef struct
+{
+  uint32_t op;
+  int32_t key;
+  uint32_t check; // 중간에 잘린(torn) 기록을 걸러내기 위한 값
+} wal_record_t;
+
+int wal_recover(durable_rbtree *d);
+int load_checkpoint(durable_rbtree *d);
+int replay_log(durable_rbtree *d);
+int rotate_log(durable_rbtree *d, off_t from, off_t end, uint32_t generation);
+int append_record(durable_rbtree *d, uint32_t op, key_t key);
+int sync_log(durable_rbtree *d);
+int checkpoint_log(durable_rbtree *d);
+int write_checkpoint(durable_rbtree *d, uint32_t generation, uint64_t log_offset, const key_t *keys, uint64_t count);
+void maybe_checkpoint(durable_rbtree *d);
+void *flusher_main(void *arg);
+void free_durable(durable_rbtree *d);
+int write_all(int fd, const void *buf, size_t len);
+int read_all(int fd, void *buf, size_t len);
+int fsync_dir(const char *path);
+uint32_t record_check(uint32_t op, int32_t key);
+long elapsed_usec(const struct timespec *since);
+char *path_with_suffix(const char *path, const char *suffix);
+
+static const wal_options_t default_options = {
+    .group_commit_records = 64,
+    .group_commit_usec = 1000,
+    .checkpoint_records = 1 << 20,
+};
+
+/* 1️⃣ durable tree 열기 */
+// `path`.ckpt와 `path`.log를 읽어 tree를 복구하는 함수 (파일이 없으면 빈 tree로 시작)
+// `options`가 NULL이면 기본값을 사용한다. 실패하면 NULL 반환
+durable_rbtree *durable_rbtree_open(const char *path, const wal_options_t *options)
+{
+  durable_rbtree *d = (durable_rbtree *)calloc(1, sizeof(durable_rbtree));
+  d->tree = new_rbtree();
+  d->options = options ? *options : default_options;
+  d->log_fd = -1;
+  d->log_path = path_with_suffix(path, ".log");
+  d->ckpt_path = path_with_suffix(path, ".ckpt");
+
+  // 디렉토리 fsync용 경로 ('/'가 없으면 현재 디렉토리)
+  const char *slash = strrchr(path, '/');
+  d->dir_path = slash ? strndup(path, slash - path + 1) : strdup(".");
+
+  // flusher의 대기 시간은 first_unsynced와 같은 시계로 잰다.
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&d->wake, &attr);
+  pthread_cond_init(&d->synced, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&d->lock, NULL);
+
+  int ok = wal_recover(d) == 0;
+  if (ok && d->options.group_commit_usec > 0)
+    ok = d->has_flusher = pthread_create(&d->flusher, NULL, flusher_main, d) == 0;
+  if (!ok)
+  {
+    if (d->log_fd >= 0)
+      close(d->log_fd);
+    free_durable(d);
+    return NULL;
+  }
+  return d;
+}
+
+/* 2️⃣ durable tree 닫기 */
+// 남은 기록을 fsync한 뒤 메모리를 반환하는 함수
+int durable_rbtree_close(durable_rbtree *d)
+{
+  if (d->has_flusher)
+  {
+    pthread_mutex_lock(&d->lock);
+    d->closing = 1;
+    pthread_cond_signal(&d->wake);
+    pthread_mutex_unlock(&d->lock);
+    pthread_join(d->flusher, NULL);
+  }
+
+  int ret = durable_rbtree_sync(d);
+  if (close(d->log_fd) != 0)
+    ret = -1;
+  free_durable(d);
+  return ret;
+}
+
+/* 3️⃣ key 추가 */
+// 로그에 먼저 기록한 뒤 tree에 반영한다. 로그 기록에 실패하면 tree는 그대로 두고 NULL 반환
+// `lsn`이 NULL이 아니면 기록 번호를 담는다. (durable_rbtree_wait로 내구화를 기다릴 때 사용)
+node_t *durable_rbtree_insert(durable_rbtree *d, const key_t key, uint64_t *lsn)
+{
+  pthread_mutex_lock(&d->lock);
+  node_t *p = NULL;
+  if (append_record(d, WAL_OP_INSERT, key) == 0)
+  {
+    p = rbtree_insert(d->tree, key);
+    if (lsn != NULL)
+      *lsn = d->lsn;
+    maybe_checkpoint(d);
+  }
+  pthread_mutex_unlock(&d->lock);
+  return p;
+}
+
+/* 4️⃣ node 삭제 */
+// 로그에는 key만 남긴다. (같은 key의 노드는 서로 구분할 필요가 없으므로 복구 시 아무 노드나 지워도 된다.)
+int durable_rbtree_erase(durable_rbtree *d, node_t *p, uint64_t *lsn)
+{
+  pthread_mutex_lock(&d->lock);
+  int ret = append_record(d, WAL_OP_ERASE, p->key);
+  if (ret == 0)
+  {
+    rbtree_erase(d->tree, p);
+    if (lsn != NULL)
+      *lsn = d->lsn;
+    maybe_checkpoint(d);
+  }
+  pthread_mutex_unlock(&d->lock);
+  return ret;
+}
+
+/* 5️⃣ group commit */
+// `lsn`번 기록까지 디스크에 내려갈 때까지 기다리는 함수 (내구화되면 0, 그 기록의 fsync가 실패했으면 -1)
+// 같은 창 안의 기록은 flusher의 fsync 한 번으로 함께 내구화된다.
+// flusher가 없거나 snapshot을 쓰는 중이면 기다리지 않고 직접 fsync한다.
+int durable_rbtree_wait(durable_rbtree *d, uint64_t lsn)
+{
+  pthread_mutex_lock(&d->lock);
+  if (lsn > d->lsn)
+    lsn = d->lsn;
+
+  int ret;
+  while (1)
+  {
+    if (d->sync_failed && lsn <= d->failed_lsn)
+    {
+      ret = -1;
+      break;
+    }
+    if (d->synced_lsn >= lsn)
+    {
+      ret = 0;
+      break;
+    }
+    if (!d->has_flusher || d->checkpointing)
+      sync_log(d);
+    else
+      pthread_cond_wait(&d->synced, &d->lock);
+  }
+  pthread_mutex_unlock(&d->lock);
+  return ret;
+}
+
+// 아직 fsync되지 않은 기록을 모두 디스크에 내리는 함수
+// 호출하면 group commit 창을 기다리지 않고 대기 중인 기록이 바로 내구화된다.
+// 이전 group commit fsync가 실패했다면 다음 checkpoint가 성공할 때까지 -1을 반환한다.
+int durable_rbtree_sync(durable_rbtree *d)
+{
+  pthread_mutex_lock(&d->lock);
+  int ret = sync_log(d);
+  if (d->sync_failed)
+    ret = -1;
+  pthread_mutex_unlock(&d->lock);
+  return ret;
+}
+
+/* 6️⃣ checkpoint */
+// 현재 tree 전체를 snapshot으로 저장하고 로그를 비우는 함수
+// snapshot과 새 로그에는 다음 세대 번호가 붙는다. snapshot에는 이전 세대 로그의 어디까지를 담았는지도 기록하므로,
+// snapshot 교체 직후 중단되더라도 그 뒤의 기록만 재실행되어 같은 기록이 두 번 적용되지 않는다.
+int durable_rbtree_checkpoint(durable_rbtree *d)
+{
+  pthread_mutex_lock(&d->lock);
+  while (d->checkpointing)
+    pthread_cond_wait(&d->synced, &d->lock);
+  int ret = checkpoint_log(d);
+  pthread_mutex_unlock(&d->lock);
+  return ret;
+}
+
+// durable_rbtree_checkpoint의 본체 (lock을 잡은 상태에서 호출)
+// tree를 배열로 복사하는 동안만 lock을 잡고, snapshot 파일은 lock을 풀고 쓴다. (그동안 기록은 현재 로그에 계속 쌓인다.)
+// snapshot이 tree 전체를 담으므로 로그 fsync가 실패했더라도 checkpoint가 성공하면 다시 내구성이 보장된다.
+int checkpoint_log(durable_rbtree *d)
+{
+  d->checkpointing = 1;
+  d->checkpoint_due = 0;
+
+  uint32_t next_generation = d->generation + 1;
+  uint64_t count = d->tree->size;
+  key_t *keys = (key_t *)calloc(count ? count : 1, sizeof(key_t));
+  if (count > 0)
+    rbtree_to_array(d->tree, keys, count);
+  off_t offset = d->log_fd >= 0 ? lseek(d->log_fd, 0, SEEK_CUR) : -1;
+
+  pthread_mutex_unlock(&d->lock);
+  int ok = offset >= 0 && write_checkpoint(d, next_generation, (uint64_t)offset, keys, count) == 0;
+  free(keys);
+  pthread_mutex_lock(&d->lock);
+
+  // snapshot이 자리를 잡았으면 그 뒤에 쌓인 기록만 새 세대 로그로 옮긴다.
+  // 옮기지 못해도 이전 세대 로그는 복구 시 offset부터 재실행되므로 계속 써도 된다.
+  if (ok)
+    ok = rotate_log(d, offset, lseek(d->log_fd, 0, SEEK_CUR), next_generation) == 0;
+  if (ok)
+    d->sync_failed = 0;
+
+  d->checkpointing = 0;
+  pthread_cond_broadcast(&d->synced);
+  return ok ? 0 : -1;
+}
+
+// `generation` 세대의 snapshot을 임시 파일에 쓰고 원자적으로 교체하는 함수 (lock 없이 호출)
+int write_checkpoint(durable_rbtree *d, uint32_t generation, uint64_t log_offset, const key_t *keys, uint64_t count)
+{
+  char *tmp_path = path_with_suffix(d->ckpt_path, ".tmp");
+  int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+  {
+    free(tmp_path);
+    return -1;
+  }
+
+  wal_header_t header = {WAL_CKPT_MAGIC, generation};
+  uint32_t checksum = WAL_CKPT_MAGIC * 31 + (uint32_t)log_offset;
+  for (uint64_t i = 0; i < count; i++)
+    checksum = checksum * 31 + (uint32_t)keys[i];
+
+  int ok = write_all(fd, &header, sizeof(header)) == 0 &&
+           write_all(fd, &count, sizeof(count)) == 0 &&
+           write_all(fd, &log_offset, sizeof(log_offset)) == 0 &&
+           write_all(fd, keys, count * sizeof(key_t)) == 0 &&
+           write_all(fd, &checksum, sizeof(checksum)) == 0 &&
+           fsync(fd) == 0;
+  if (close(fd) != 0)
+    ok = 0;
+
+  if (ok)
+    ok = rename(tmp_path, d->ckpt_path) == 0 && fsync_dir(d->dir_path) == 0;
+  free(tmp_path);
+  return ok ? 0 : -1;
+}
+
+// checkpoint를 불러오고 같은 세대의 로그를 이어서 재실행하는 함수
+int wal_recover(durable_rbtree *d)
+{
+  if (load_checkpoint(d) != 0)
+    return -1;
+  return replay_log(d);
+}
+
+// checkpoint 파일을 읽어 tree와 세대 번호를 채우는 함수 (파일이 없으면 세대 0의 빈 tree)
+int load_checkpoint(durable_rbtree *d)
+{
+  int fd = open(d->ckpt_path, O_RDONLY);
+  if (fd < 0)
+    return errno == ENOENT ? 0 : -1;
+
+  wal_header_t header;
+  uint64_t count, log_offset;
+  int ok = read_all(fd, &header, sizeof(header)) == 0 && header.magic == WAL_CKPT_MAGIC &&
+           read_all(fd, &count, sizeof(count)) == 0 &&
+           read_all(fd, &log_offset, sizeof(log_offset)) == 0;
+
+  key_t *keys = NULL;
+  if (ok)
+  {
+    keys = (key_t *)calloc(count ? count : 1, sizeof(key_t));
+    uint32_t checksum, expected = WAL_CKPT_MAGIC * 31 + (uint32_t)log_offset;
+    ok = read_all(fd, keys, count * sizeof(key_t)) == 0 &&
+         read_all(fd, &checksum, sizeof(checksum)) == 0;
+    for (uint64_t i = 0; ok && i < count; i++)
+      expected = expected * 31 + (uint32_t)keys[i];
+    // checkpoint는 rename으로 통째로 교체되므로, 내용이 맞지 않으면 복구하지 않고 실패시킨다.
+    ok = ok && checksum == expected;
+  }
+  close(fd);
+
+  if (ok)
+  {
+    rbtree_insert_batch(d->tree, keys, count);
+    d->generation = header.generation;
+    d->ckpt_log_offset = log_offset;
+  }
+  free(keys);
+  return ok ? 0 : -1;
+}
+
+// 로그의 유효한 기록을 tree에 재실행하고, 잘린 꼬리는 잘라내는 함수
+int replay_log(durable_rbtree *d)
+{
+  int fd = open(d->log_path, O_RDWR);
+  if (fd < 0)
+    return errno == ENOENT ? rotate_log(d, 0, 0, d->generation) : -1;
+
+  wal_header_t header;
+  if (read_all(fd, &header, sizeof(header)) != 0 || header.magic != WAL_LOG_MAGIC ||
+      header.generation + 1 < d->generation)
+  {
+    // 헤더가 깨졌거나 이미 checkpoint에 모두 반영된 세대의 로그: 새 로그로 교체
+    close(fd);
+    return rotate_log(d, 0, 0, d->generation);
+  }
+  if (header.generation > d->generation)
+  {
+    // checkpoint보다 새로운 로그는 checkpoint가 사라졌다는 뜻이므로 복구할 수 없다.
+    close(fd);
+    return -1;
+  }
+
+  // 바로 이전 세대의 로그는 snapshot이 담지 못한 offset 뒤부터 재실행한다.
+  off_t start = header.generation == d->generation ? (off_t)sizeof(header) : (off_t)d->ckpt_log_offset;
+  if (lseek(fd, start, SEEK_SET) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  off_t valid_end = start;
+  wal_record_t record;
+  while (read_all(fd, &record, sizeof(record)) == 0 && record.check == record_check(record.op, record.key))
+  {
+    if (record.op == WAL_OP_INSERT)
+      rbtree_insert(d->tree, record.key);
+    else if (record.op == WAL_OP_ERASE)
+    {
+      node_t *p = rbtree_find(d->tree, record.key);
+      if (p != NULL)
+        rbtree_erase(d->tree, p);
+    }
+    valid_end += sizeof(record);
+    d->logged++;
+  }
+
+  d->log_fd = fd;
+  if (header.generation != d->generation)
+    // snapshot 교체 후 로그 교체 전에 중단된 경우: 남은 기록을 snapshot 세대의 로그로 옮긴다.
+    return rotate_log(d, start, valid_end, d->generation);
+
+  // 마지막으로 온전한 기록 뒤부터 이어서 쓴다.
+  if (ftruncate(fd, valid_end) != 0 || fsync(fd) != 0 || lseek(fd, 0, SEEK_END) < 0)
+  {
+    close(fd);
+    d->log_fd = -1;
+    return -1;
+  }
+  return 0;
+}
+
+// 현재 로그의 [`from`, `end`) 기록을 담은 `generation` 세대의 새 로그로 현재 로그를 교체하는 함수
+// 새 로그가 자리를 잡기 전에 실패하면 현재 로그를 그대로 둔다.
+int rotate_log(durable_rbtree *d, off_t from, off_t end, uint32_t generation)
+{
+  size_t tail = end > from ? (size_t)(end - from) : 0;
+  char *records = (char *)malloc(tail ? tail : 1);
+  if (tail > 0 && (lseek(d->log_fd, from, SEEK_SET) < 0 || read_all(d->log_fd, records, tail) != 0 ||
+                   lseek(d->log_fd, end, SEEK_SET) < 0))
+  {
+    free(records);
+    return -1;
+  }
+
+  char *tmp_path = path_with_suffix(d->log_path, ".tmp");
+  int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  wal_header_t header = {WAL_LOG_MAGIC, generation};
+  int ok = fd >= 0 && write_all(fd, &header, sizeof(header)) == 0 && write_all(fd, records, tail) == 0 &&
+           fsync(fd) == 0 && rename(tmp_path, d->log_path) == 0 && fsync_dir(d->dir_path) == 0;
+  free(tmp_path);
+  free(records);
+  if (!ok)
+  {
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+
+  if (d->log_fd >= 0)
+    close(d->log_fd);
+  d->log_fd = fd;
+  d->generation = generation;
+  d->logged = tail / sizeof(wal_record_t);
+  d->unsynced = 0;
+  d->synced_lsn = d->lsn;
+  return 0;
+}
+
+// 기록 하나를 로그에 추가하고 group commit 조건을 확인하는 함수
+// write가 성공하면 기록은 로그에 남으므로, 이어지는 fsync가 실패해도 0을 반환해 tree에 반영하게 한다.
+// (fsync 실패는 sync_failed로 남아 durable_rbtree_sync/close에서 드러난다.)
+int append_record(durable_rbtree *d, uint32_t op, key_t key)
+{
+  wal_record_t record = {op, key, record_check(op, key)};
+  if (write_all(d->log_fd, &record, sizeof(record)) != 0)
+    return -1;
+
+  if (d->unsynced++ == 0)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &d->first_unsynced);
+    pthread_cond_signal(&d->wake); // flusher가 시간 창을 재기 시작하도록
+  }
+  d->lsn++;
+  d->logged++;
+
+  // 기록이 충분히 모였으면 한 번의 fsync로 함께 내린다. (시간 조건은 flusher가 맡는다.)
+  if (d->unsynced >= d->options.group_commit_records)
+    sync_log(d);
+  return 0;
+}
+
+// 대기 중인 기록을 fsync하는 함수 (lock을 잡은 상태에서 호출)
+// fsync가 한 번 실패하면 커널이 더티 페이지를 버렸을 수 있어 재시도의 성공을 믿을 수 없으므로,
+// 대기 기록을 비우고 sync_failed를 남긴다.
+int sync_log(durable_rbtree *d)
+{
+  if (d->unsynced == 0)
+    return 0;
+  d->unsynced = 0;
+  int ret = fsync(d->log_fd);
+  if (ret != 0)
+  {
+    d->sync_failed = 1;
+    d->failed_lsn = d->lsn;
+  }
+  else
+    d->synced_lsn = d->lsn;
+  pthread_cond_broadcast(&d->synced);
+  return ret == 0 ? 0 : -1;
+}
+
+// 로그가 충분히 길어졌으면 checkpoint하는 함수 (변경이 tree에 반영된 뒤에 호출해야 한다.)
+// flusher가 있으면 flusher에게 맡겨 writer가 snapshot을 기다리지 않게 한다.
+// 실패해도 방금 기록은 이미 로그에 있으므로 무시하고, 로그를 더 쓸 수 없게 됐다면 다음 기록에서 드러난다.
+void maybe_checkpoint(durable_rbtree *d)
+{
+  if (d->options.checkpoint_records == 0 || d->logged < d->options.checkpoint_records || d->checkpointing)
+    return;
+  if (d->has_flusher)
+  {
+    d->checkpoint_due = 1;
+    pthread_cond_signal(&d->wake);
+  }
+  else
+    checkpoint_log(d);
+}
+
+// 첫 미동기화 기록 후 group_commit_usec가 지나면 fsync하고, 로그가 길어지면 checkpoint하는 스레드
+// 다음 기록이 오지 않아도 시간 창이 끝나면 대기 중인 기록이 내구화된다.
+void *flusher_main(void *arg)
+{
+  durable_rbtree *d = (durable_rbtree *)arg;
+  pthread_mutex_lock(&d->lock);
+  while (!d->closing)
+  {
+    if (d->checkpoint_due && !d->checkpointing)
+      checkpoint_log(d);
+    else if (d->unsynced == 0)
+      pthread_cond_wait(&d->wake, &d->lock);
+    else if (elapsed_usec(&d->first_unsynced) >= d->options.group_commit_usec)
+      sync_log(d);
+    else
+    {
+      // 기다리는 동안 기록 개수 조건으로 먼저 fsync됐을 수 있으므로 깨어나면 처음부터 다시 확인한다.
+      struct timespec deadline = d->first_unsynced;
+      deadline.tv_sec += d->options.group_commit_usec / 1000000;
+      deadline.tv_nsec += d->options.group_commit_usec % 1000000 * 1000;
+      if (deadline.tv_nsec >= 1000000000L)
+      {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait(&d->wake, &d->lock, &deadline);
+    }
+  }
+  pthread_mutex_unlock(&d->lock);
+  return NULL;
+}
+
+// 로그 fd를 제외한 durable tree의 자원을 반환하는 함수
+void free_durable(durable_rbtree *d)
+{
+  pthread_cond_destroy(&d->wake);
+  pthread_cond_destroy(&d->synced);
+  pthread_mutex_destroy(&d->lock);
+  delete_rbtree(d->tree);
+  free(d->log_path);
+  free(d->ckpt_path);
+  free(d->dir_path);
+  free(d);
+}
+
+int write_all(int fd, const void *buf, size_t len)
+{
+  const char *p = (const char *)buf;
+  while (len > 0)
+  {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+// `len` 바이트를 모두 읽지 못하면 (파일 끝 포함) -1 반환
+int read_all(int fd, void *buf, size_t len)
+{
+  char *p = (char *)buf;
+  while (len > 0)
+  {
+    ssize_t n = read(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+// rename 결과가 디스크에 남도록 디렉토리를 fsync하는 함수
+int fsync_dir(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+  int ret = fsync(fd);
+  close(fd);
+  return ret;
+}
+
+uint32_t record_check(uint32_t op, int32_t key)
+{
+  return (WAL_LOG_MAGIC ^ op) * 2654435761u ^ (uint32_t)key;
+}
+
+long elapsed_usec(const struct timespec *since)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - since->tv_sec) * 1000000L + (now.tv_nsec - since->tv_nsec) / 1000;
+}
+
+char *path_with_suffix(const char *path, const char *suffix)
+{
+  size_t len = strlen(path);
+  char *result = (char *)malloc(len + strlen(suffix) + 1);
+  memcpy(result, path, len);
+  strcpy(result + len, suffix);
+  return result;
+}
@@ -0,0 +1,57 @@
+#ifndef _RBTREE_WAL_H_
+#define _RBTREE_WAL_H_
+
+#include "rbtree.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+// group commit / checkpoint 설정
+typedef struct {
+  size_t group_commit_records;  // 동기화되지 않은 기록이 이만큼 쌓이면 fsync (0이면 매 기록마다 fsync)
+  long group_commit_usec;       // 첫 미동기화 기록 후 이 시간(us)이 지나면 flusher 스레드가 fsync (0이면 시간 제한 없음)
+  size_t checkpoint_records;    // 로그 기록이 이만큼 쌓이면 flusher 스레드가 checkpoint (0이면 자동 checkpoint 없음)
+} wal_options_t;
+
+// write-ahead log로 변경을 기록하는 tree
+// 조회는 `tree`에 대해 rbtree_find/rbtree_min 등을 그대로 사용하고, 변경은 durable_rbtree_* 함수로만 한다.
+// insert/erase는 기록이 로그에 쓰이면 반환하며, 기록 번호(lsn)를 durable_rbtree_wait에 넘기면 그 기록이
+// group commit fsync로 디스크에 내려갈 때까지 기다린다. fsync 실패는 wait/sync/close가 -1로 알린다.
+typedef struct {
+  rbtree *tree;
+
+  char *log_path, *ckpt_path, *dir_path;
+  int log_fd;
+  uint32_t generation;  // 현재 로그 파일의 세대 (checkpoint마다 1씩 증가)
+  uint64_t ckpt_log_offset;  // 복구 시: snapshot이 이전 세대 로그를 담은 끝 위치
+
+  wal_options_t options;
+  size_t unsynced;  // fsync되지 않은 기록 개수
+  size_t logged;    // 마지막 checkpoint 이후 기록 개수
+  struct timespec first_unsynced;
+  uint64_t lsn;         // 마지막으로 로그에 쓴 기록의 번호 (open 이후 1부터)
+  uint64_t synced_lsn;  // 이 번호까지의 기록은 디스크에 내려갔다.
+  uint64_t failed_lsn;  // 마지막 fsync 실패 때의 lsn (이 번호까지의 기록은 내구화를 보장할 수 없다.)
+  int sync_failed;      // group commit fsync가 실패한 뒤 다음 checkpoint 전까지 1
+
+  // group_commit_usec 창이 끝나면 fsync하고 자동 checkpoint를 맡는 스레드 (로그 접근은 lock으로 보호)
+  pthread_mutex_t lock;
+  pthread_cond_t wake;    // flusher를 깨운다.
+  pthread_cond_t synced;  // fsync나 checkpoint가 끝날 때마다 기다리는 스레드를 깨운다.
+  pthread_t flusher;
+  int has_flusher, closing;
+  int checkpoint_due, checkpointing;
+} durable_rbtree;
+
+durable_rbtree *durable_rbtree_open(const char *, const wal_options_t *);
+int durable_rbtree_close(durable_rbtree *);
+
+node_t *durable_rbtree_insert(durable_rbtree *, const key_t, uint64_t *);
+int durable_rbtree_erase(durable_rbtree *, node_t *, uint64_t *);
+
+int durable_rbtree_wait(durable_rbtree *, uint64_t);
+int durable_rbtree_sync(durable_rbtree *);
+int durable_rbtree_checkpoint(durable_rbtree *);
+
+#endif  // _RBTREE_WAL_H_
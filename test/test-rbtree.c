@@ -1,8 +1,15 @@
 #include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <rbset.h>
 #include <rbtree.h>
+#include <rbtree_str.h>
+#include <rbtree_wal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 // new_rbtree should return rbtree struct with null root node
 void test_init(void) {
@@ -342,10 +349,10 @@ void test_find_erase(rbtree *t, const key_t *arr, const size_t n) {
   }
 }
 
-void test_find_erase_fixed() {
+void test_find_erase_fixed_with(const balance_t balance) {
   const key_t arr[] = {10, 5, 8, 34, 67, 23, 156, 24, 2, 12, 24, 36, 990, 25};
   const size_t n = sizeof(arr) / sizeof(arr[0]);
-  rbtree *t = new_rbtree();
+  rbtree *t = new_rbtree_with_balance(balance);
   assert(t != NULL);
 
   test_find_erase(t, arr, n);
@@ -353,6 +360,10 @@ void test_find_erase_fixed() {
   delete_rbtree(t);
 }
 
+void test_find_erase_fixed() {
+  test_find_erase_fixed_with(RBTREE_BALANCE_RB);
+}
+
 void test_find_erase_rand(const size_t n, const unsigned int seed) {
   srand(seed);
   rbtree *t = new_rbtree();
@@ -367,6 +378,739 @@ void test_find_erase_rand(const size_t n, const unsigned int seed) {
   delete_rbtree(t);
 }
 
+static int str_comp(const void *p1, const void *p2) {
+  return strcmp(*(const char *const *)p1, *(const char *const *)p2);
+}
+
+static size_t count_stale_prefixes(const str_rbtree *t, const node_t *p) {
+  if (p == t->tree.nil) {
+    return 0;
+  }
+  return (((const str_node_t *)p)->prefix_at != t->common_len) +
+         count_stale_prefixes(t, p->left) + count_stale_prefixes(t, p->right);
+}
+
+// string-key tree should order keys like strcmp, including shared prefixes
+void test_str_rbtree() {
+  const char *keys[] = {"https://example.com/b", "https://example.com/a",
+                        "https://example.com",   "https://",
+                        "abc",                   "ab",
+                        "https://example.com/a", "zzzzzzzzzz",
+                        "",                      "abcdefgh"};
+  const size_t n = sizeof(keys) / sizeof(keys[0]);
+
+  str_rbtree *t = new_str_rbtree();
+  assert(t != NULL);
+  for (size_t i = 0; i < n; i++) {
+    str_node_t *p = str_rbtree_insert(t, keys[i], strlen(keys[i]));
+    assert(p != NULL);
+    assert(p->key != keys[i]);  // key should be copied into the tree
+  }
+  test_color_constraint(&t->tree);
+
+  const char **sorted = calloc(n, sizeof(char *));
+  memcpy(sorted, keys, n * sizeof(char *));
+  qsort(sorted, n, sizeof(char *), str_comp);
+
+  const char **res = calloc(n, sizeof(char *));
+  str_rbtree_to_array(t, res, n);
+  for (size_t i = 0; i < n; i++) {
+    assert(strcmp(sorted[i], res[i]) == 0);
+  }
+  assert(strcmp(str_rbtree_min(t)->key, "") == 0);
+  assert(strncmp(str_rbtree_max(t)->key, "zzzzzzzzzz", 10) == 0);
+
+  assert(str_rbtree_find(t, "https://example.com/c", 21) == NULL);
+  assert(str_rbtree_find(t, "abcd", 4) == NULL);
+  for (size_t i = 0; i < n; i++) {
+    str_node_t *p = str_rbtree_find(t, keys[i], strlen(keys[i]));
+    assert(p != NULL);
+    assert(p->len == strlen(keys[i]));
+    assert(memcmp(p->key, keys[i], p->len) == 0);
+    str_rbtree_erase(t, p);
+    test_color_constraint(&t->tree);
+  }
+  assert(t->tree.root == t->tree.nil);
+  assert(str_rbtree_min(t) == NULL);
+
+  // keys sharing a long prefix: node prefixes should start after it
+  const char *base = "https://www.example.com/item/";
+  const size_t base_len = strlen(base);
+  char url[64];
+  for (int i = 0; i < 100; i++) {
+    snprintf(url, sizeof(url), "%s%02d/index.html", base, i * 7919 % 100);
+    str_rbtree_insert(t, url, strlen(url));
+  }
+  assert(t->common_len == base_len);
+  snprintf(url, sizeof(url), "%s%02d/index.html", base, 42);
+  assert(str_rbtree_find(t, url, strlen(url))->prefix != str_rbtree_min(t)->prefix);
+  assert(str_rbtree_find(t, "https://www.example.org/", 24) == NULL);
+
+  // a key outside the common prefix shrinks it; every key must still be found
+  str_rbtree_insert(t, "http://", 7);
+  assert(t->common_len == 4);
+  test_color_constraint(&t->tree);
+  // prefixes are recomputed lazily, not inside the insert
+  assert(count_stale_prefixes(t, t->tree.root) > 0);
+  for (int i = 0; i < 100; i++) {
+    snprintf(url, sizeof(url), "%s%02d/index.html", base, i);
+    str_node_t *p = str_rbtree_find(t, url, strlen(url));
+    assert(p != NULL);
+    str_rbtree_erase(t, p);
+  }
+  assert(str_rbtree_find(t, "http://", 7) != NULL);
+  str_rbtree_erase(t, str_rbtree_find(t, "http://", 7));
+  assert(t->common == NULL);
+
+  free(res);
+  free(sorted);
+  delete_str_rbtree(t);
+}
+
+// erased keys should give their bytes back to the arena under churn
+void test_str_arena_churn(const size_t n, const int rounds) {
+  str_rbtree *t = new_str_rbtree();
+  char key[32];
+  size_t live_bytes = 0;
+  for (size_t i = 0; i < n; i++) {
+    live_bytes += snprintf(key, sizeof(key), "key-%zu", i) + 1;
+    str_rbtree_insert(t, key, strlen(key));
+  }
+
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < n; i++) {
+      snprintf(key, sizeof(key), "key-%zu", i);
+      str_rbtree_erase(t, str_rbtree_find(t, key, strlen(key)));
+      str_rbtree_insert(t, key, strlen(key));
+    }
+    assert(t->arena_bytes - t->dead_bytes == live_bytes);
+    assert(t->arena_bytes <= 2 * live_bytes + 4096);
+  }
+  test_color_constraint(&t->tree);
+  for (size_t i = 0; i < n; i++) {
+    snprintf(key, sizeof(key), "key-%zu", i);
+    assert(str_rbtree_find(t, key, strlen(key)) != NULL);
+  }
+  delete_str_rbtree(t);
+}
+
+static void assert_tree_keys(const rbtree *t, const key_t *expected, const size_t n) {
+  key_t *res = calloc(n, sizeof(key_t));
+  rbtree_to_array(t, res, n);
+  for (size_t i = 0; i < n; i++) {
+    assert(res[i] == expected[i]);
+  }
+  free(res);
+}
+
+// durable tree should recover checkpoint + log tail and ignore a torn record
+void test_durable_rbtree() {
+  const char *path = "test-durable";
+  unlink("test-durable.log");
+  unlink("test-durable.ckpt");
+
+  wal_options_t options = {.group_commit_records = 8,
+                           .group_commit_usec = 1000000,
+                           .checkpoint_records = 0};
+  durable_rbtree *d = durable_rbtree_open(path, &options);
+  assert(d != NULL);
+  for (key_t k = 0; k < 20; k++) {
+    assert(durable_rbtree_insert(d, k, NULL) != NULL);
+  }
+  assert(durable_rbtree_checkpoint(d) == 0);
+
+  // log tail after the checkpoint
+  durable_rbtree_erase(d, rbtree_find(d->tree, 3), NULL);
+  durable_rbtree_erase(d, rbtree_find(d->tree, 7), NULL);
+  durable_rbtree_insert(d, 7, NULL);
+  durable_rbtree_insert(d, 100, NULL);
+  assert(durable_rbtree_close(d) == 0);
+
+  // a half-written record at the end of the log should be dropped on recovery
+  FILE *log = fopen("test-durable.log", "ab");
+  fwrite("\x01\x00\x00", 1, 3, log);
+  fclose(log);
+
+  key_t expected[20];
+  size_t n = 0;
+  for (key_t k = 0; k < 20; k++) {
+    if (k != 3) {
+      expected[n++] = k;
+    }
+  }
+  expected[n++] = 100;
+
+  d = durable_rbtree_open(path, &options);
+  assert(d != NULL);
+  assert(d->tree->size == n);
+  assert_tree_keys(d->tree, expected, n);
+  test_color_constraint(d->tree);
+
+  // records appended after recovery should land after the truncated tail
+  durable_rbtree_erase(d, rbtree_find(d->tree, 100), NULL);
+  assert(durable_rbtree_close(d) == 0);
+
+  d = durable_rbtree_open(path, NULL);
+  assert(d != NULL);
+  assert(d->tree->size == n - 1);
+  assert_tree_keys(d->tree, expected, n - 1);
+  assert(durable_rbtree_close(d) == 0);
+
+  unlink("test-durable.log");
+  unlink("test-durable.ckpt");
+}
+
+// the flusher should sync an idle window, and a failed group fsync should not fail the apply
+// but should fail the wait for its record
+void test_durable_group_commit() {
+  const char *path = "test-durable";
+  unlink("test-durable.log");
+  unlink("test-durable.ckpt");
+
+  wal_options_t options = {.group_commit_records = 1000,
+                           .group_commit_usec = 2000,
+                           .checkpoint_records = 0};
+  durable_rbtree *d = durable_rbtree_open(path, &options);
+  assert(d != NULL);
+  uint64_t lsn;
+  assert(durable_rbtree_insert(d, 1, &lsn) != NULL);
+  assert(durable_rbtree_wait(d, lsn) == 0);
+  pthread_mutex_lock(&d->lock);
+  assert(d->unsynced == 0);
+  assert(d->synced_lsn >= lsn);
+  pthread_mutex_unlock(&d->lock);
+
+  // fsync on a pipe fails after the write succeeds
+  int fds[2];
+  assert(pipe(fds) == 0);
+  pthread_mutex_lock(&d->lock);
+  close(d->log_fd);
+  d->log_fd = fds[1];
+  d->options.group_commit_records = 1;
+  pthread_mutex_unlock(&d->lock);
+  assert(durable_rbtree_insert(d, 2, &lsn) != NULL);
+  assert(rbtree_find(d->tree, 2) != NULL);
+  assert(durable_rbtree_wait(d, lsn) == -1);
+  assert(durable_rbtree_sync(d) == -1);
+  close(fds[0]);
+
+  // put the real log back, as if the failed fsync had dropped the record
+  pthread_mutex_lock(&d->lock);
+  close(d->log_fd);
+  d->log_fd = open("test-durable.log", O_RDWR);
+  assert(lseek(d->log_fd, 0, SEEK_END) > 0);
+  pthread_mutex_unlock(&d->lock);
+
+  // a checkpoint captures the whole tree and clears the error
+  assert(durable_rbtree_checkpoint(d) == 0);
+  assert(durable_rbtree_sync(d) == 0);
+  assert(durable_rbtree_close(d) == 0);
+
+  const key_t expected[] = {1, 2};
+  d = durable_rbtree_open(path, NULL);
+  assert(d != NULL);
+  assert_tree_keys(d->tree, expected, 2);
+  assert(durable_rbtree_close(d) == 0);
+
+  unlink("test-durable.log");
+  unlink("test-durable.ckpt");
+}
+
+// automatic checkpoints should run on the flusher, and a crash between replacing the
+// snapshot and replacing the log should replay only the records the snapshot missed
+void test_durable_checkpoint(const size_t n) {
+  const char *path = "test-durable";
+  unlink("test-durable.log");
+  unlink("test-durable.ckpt");
+
+  wal_options_t options = {.group_commit_records = 16,
+                           .group_commit_usec = 500,
+                           .checkpoint_records = n / 10};
+  durable_rbtree *d = durable_rbtree_open(path, &options);
+  assert(d != NULL);
+  uint64_t lsn = 0;
+  key_t *expected = calloc(n + 5, sizeof(key_t));
+  for (size_t i = 0; i < n; i++) {
+    expected[i] = (key_t)i;
+    assert(durable_rbtree_insert(d, (key_t)i, &lsn) != NULL);
+  }
+  assert(durable_rbtree_wait(d, lsn) == 0);
+  assert(durable_rbtree_close(d) == 0);
+
+  options.checkpoint_records = 0;
+  d = durable_rbtree_open(path, &options);
+  assert(d != NULL);
+  assert(d->generation > 0);
+  assert(d->tree->size == n);
+  assert_tree_keys(d->tree, expected, n);
+
+  for (size_t i = n; i < n + 5; i++) {
+    expected[i] = (key_t)i;
+    durable_rbtree_insert(d, (key_t)i, NULL);
+  }
+  assert(durable_rbtree_sync(d) == 0);
+  FILE *log = fopen("test-durable.log", "rb");
+  char *old_log = malloc(1 << 16);
+  const size_t old_len = fread(old_log, 1, 1 << 16, log);
+  fclose(log);
+  assert(durable_rbtree_checkpoint(d) == 0);
+  assert(durable_rbtree_close(d) == 0);
+
+  // the previous-generation log comes back, as if the crash hit before the log rotation
+  log = fopen("test-durable.log", "wb");
+  fwrite(old_log, 1, old_len, log);
+  fclose(log);
+
+  d = durable_rbtree_open(path, &options);
+  assert(d != NULL);
+  assert(d->tree->size == n + 5);
+  assert_tree_keys(d->tree, expected, n + 5);
+  durable_rbtree_insert(d, (key_t)(n + 5), NULL);
+  assert(durable_rbtree_close(d) == 0);
+
+  d = durable_rbtree_open(path, &options);
+  assert(d->tree->size == n + 6);
+  assert(durable_rbtree_close(d) == 0);
+
+  free(old_log);
+  free(expected);
+  unlink("test-durable.log");
+  unlink("test-durable.ckpt");
+}
+
+static size_t count_free_nodes(const rbtree *t) {
+  size_t count = 0;
+  for (const node_t *p = t->free_nodes; p != NULL; p = p->right) {
+    count++;
+  }
+  return count;
+}
+
+// batch insert should keep constraints on both the rebuild and finger paths
+void test_insert_batch(const size_t n, const unsigned int seed) {
+  srand(seed);
+  const size_t m = n / 4;
+  key_t *arr = calloc(n + m + 1, sizeof(key_t));
+  for (size_t i = 0; i < n + m; i++) {
+    arr[i] = rand() % (int)n;  // with duplicates
+  }
+
+  rbtree *t = new_rbtree();
+  node_t *p = rbtree_insert(t, -1);
+  arr[n + m] = -1;
+
+  // batch larger than the tree: merged into a freshly built tree
+  rbtree_insert_batch(t, arr, n);
+  assert(t->size == n + 1);
+  assert(rbtree_find(t, -1) == p);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  // batch smaller than the tree: inserted from the previous insertion point
+  rbtree_insert_batch(t, arr + n, m);
+  assert(t->size == n + m + 1);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  key_t *sorted = calloc(n + m + 1, sizeof(key_t));
+  memcpy(sorted, arr, (n + m + 1) * sizeof(key_t));
+  qsort(sorted, n + m + 1, sizeof(key_t), comp);
+  assert_tree_keys(t, sorted, n + m + 1);
+
+  // erased batch nodes should be reused by the next batch instead of a new block
+  // (the tail of each batch is heap-allocated, so some erased nodes are freed instead)
+  const size_t spare = count_free_nodes(t);
+  const size_t heap_before = t->heap_nodes;
+  for (size_t i = 0; i < m; i++) {
+    rbtree_erase(t, rbtree_find(t, arr[i]));
+  }
+  const size_t reusable = count_free_nodes(t);
+  assert(reusable == spare + m - (heap_before - t->heap_nodes));
+  rbtree_insert_batch(t, arr, m);
+  assert(count_free_nodes(t) == (reusable > m ? reusable - m : 0));
+  assert(t->size == n + m + 1);
+  test_color_constraint(t);
+  test_search_constraint(t);
+
+  // a block should be returned once all of its nodes are erased
+  for (int round = 0; round < 20; round++) {
+    while (t->root != t->nil) {
+      rbtree_erase(t, t->root);
+    }
+    assert(t->size == 0);
+    assert(t->blocks == NULL);
+    assert(t->free_nodes == NULL);
+    rbtree_insert_batch(t, arr, n);
+    assert(t->size == n);
+  }
+  test_color_constraint(t);
+  test_search_constraint(t);
+  delete_rbtree(t);
+
+  // a small batch should not take a whole block
+  t = new_rbtree();
+  rbtree_insert_batch(t, arr, 3);
+  assert(t->blocks == NULL);
+  assert(t->heap_nodes == 3);
+  test_color_constraint(t);
+
+  free(sorted);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// lazy erase should hide dead nodes until compaction purges them
+// checks the NODE_NO_LIVE / NODE_HAS_DEAD bits against the subtree; returns the bits
+static unsigned int assert_subtree_flags(const rbtree *t, const node_t *node) {
+  if (node == t->nil) {
+    assert(node->flags & NODE_NO_LIVE);
+    return NODE_NO_LIVE;
+  }
+  const unsigned int left = assert_subtree_flags(t, node->left);
+  const unsigned int right = assert_subtree_flags(t, node->right);
+  unsigned int expected = (left | right) & NODE_HAS_DEAD;
+  if (node->flags & NODE_DEAD) {
+    expected |= NODE_HAS_DEAD | (left & right & NODE_NO_LIVE);
+  }
+  assert((node->flags & (NODE_NO_LIVE | NODE_HAS_DEAD)) == expected);
+  return expected;
+}
+
+// inserts `arr` into a lazy-erase tree and erases the minimum n/2 times; `arr` is sorted on return
+static void erase_min_lazily(rbtree *t, key_t *arr, const size_t n) {
+  rbtree_set_lazy_erase(t, 0.25);
+  insert_arr(t, arr, n);
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  node_t *last = rbtree_max(t);
+  for (size_t i = 0; i < n / 2; i++) {
+    node_t *p = rbtree_min(t);
+    assert(p->key == arr[i]);
+    rbtree_erase(t, p);
+    if (i % 97 == 0) {
+      assert_subtree_flags(t, t->root);
+    }
+  }
+  assert(t->size == n - n / 2);
+  assert(t->dead <= 0.25 * (t->size + t->dead));
+  assert(rbtree_max(t) == last);  // purging relinks nodes instead of moving keys
+  assert(last->key == arr[n - 1]);
+  test_search_constraint(t);
+  assert_subtree_flags(t, t->root);
+  assert_tree_keys(t, arr + n / 2, n - n / 2);
+}
+
+void test_lazy_erase(const size_t n, const unsigned int seed) {
+  srand(seed);
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (size_t i = 0; i < n; i++) {
+    arr[i] = rand() % (int)(n / 2);  // with duplicates
+  }
+
+  rbtree *t = new_rbtree();
+  rbtree_set_lazy_erase(t, 2.0);  // no automatic compaction
+  insert_arr(t, arr, n);
+
+  // erase every other inserted key; duplicates must still be found
+  for (size_t i = 0; i < n; i += 2) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    rbtree_erase(t, p);
+    assert(p->flags & NODE_DEAD);
+  }
+  assert(t->size == n / 2);
+  assert(t->dead == n - n / 2);
+
+  key_t *live = calloc(n, sizeof(key_t));
+  size_t m = 0;
+  for (size_t i = 1; i < n; i += 2) {
+    live[m++] = arr[i];
+  }
+  qsort((void *)live, m, sizeof(key_t), comp);
+  assert_tree_keys(t, live, m);
+  assert(rbtree_min(t)->key == live[0]);
+  assert(rbtree_max(t)->key == live[m - 1]);
+  for (size_t i = 0; i < m; i++) {
+    assert(rbtree_find(t, live[i]) != NULL);
+  }
+
+  rbtree_compact(t);
+  assert(t->dead == 0);
+  test_color_constraint(t);
+  test_search_constraint(t);
+  assert_tree_keys(t, live, m);
+
+  // erasing past the ratio should purge a few dead nodes per erase
+  rbtree_set_lazy_erase(t, 0.25);
+  for (size_t i = 0; i < m; i++) {
+    rbtree_erase(t, rbtree_find(t, live[i]));
+    assert(t->dead <= 0.25 * (t->size + t->dead));
+  }
+  assert(t->size == 0);
+  assert(rbtree_min(t) == NULL);
+  assert(rbtree_find(t, live[0]) == NULL);
+  delete_rbtree(t);
+
+  // repeated erase-min leaves the dead nodes on the left edge; min must skip them
+  t = new_rbtree();
+  erase_min_lazily(t, arr, n);
+  test_color_constraint(t);
+  delete_rbtree(t);
+
+  free(live);
+  free(arr);
+}
+
+static void assert_set_keys(const rbset *s, const key_t *expected, const size_t n) {
+  assert(s->size == n);
+  key_t *res = calloc(n + 1, sizeof(key_t));
+  rbset_to_array(s, res, n);
+  for (size_t i = 0; i < n; i++) {
+    assert(res[i] == expected[i]);
+  }
+  free(res);
+}
+
+// rbset should promote to a tree past the inline limit and demote when small
+void test_rbset() {
+  const size_t n = RBSET_INLINE_MAX * 3;
+  key_t arr[RBSET_INLINE_MAX * 3];
+  for (size_t i = 0; i < n; i++) {
+    arr[i] = (key_t)((i * 7919) % 23);  // with duplicates
+  }
+
+  rbset *s = new_rbset();
+  assert(s != NULL);
+  key_t k;
+  assert(rbset_min(s, &k) == -1);
+  assert(rbset_erase(s, 1) == -1);
+
+  key_t sorted[RBSET_INLINE_MAX * 3];
+  for (size_t i = 0; i < n; i++) {
+    rbset_insert(s, arr[i]);
+    assert(s->is_tree == (i >= RBSET_INLINE_MAX));
+    if (s->is_tree) {
+      assert(s->tree->blocks == NULL);  // promotion should not take a node block
+    }
+    memcpy(sorted, arr, (i + 1) * sizeof(key_t));
+    qsort((void *)sorted, i + 1, sizeof(key_t), comp);
+    assert_set_keys(s, sorted, i + 1);
+  }
+  assert(rbset_find(s, 22));
+  assert(!rbset_find(s, 23));
+  assert(rbset_min(s, &k) == 0 && k == 0);
+  assert(rbset_max(s, &k) == 0 && k == 22);
+
+  for (size_t i = 0; i < n; i++) {
+    assert(rbset_erase(s, arr[i]) == 0);
+    size_t m = n - i - 1;
+    memcpy(sorted, arr + i + 1, m * sizeof(key_t));
+    qsort((void *)sorted, m, sizeof(key_t), comp);
+    assert_set_keys(s, sorted, m);
+    if (m <= RBSET_INLINE_MAX / 2) {
+      assert(!s->is_tree);
+    }
+  }
+  assert(rbset_erase(s, arr[0]) == -1);
+
+  delete_rbset(s);
+}
+
+// trees handed to the background reclaimer should all be freed
+void test_delete_async(const size_t n, const unsigned int seed) {
+  srand(seed);
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (size_t i = 0; i < n; i++) {
+    arr[i] = rand();
+  }
+
+  for (int round = 0; round < 4; round++) {
+    rbtree *heap = new_rbtree();
+    insert_arr(heap, arr, n);
+    assert(heap->heap_nodes == n);
+
+    // only block nodes: freed without visiting nodes
+    rbtree *block = new_rbtree();
+    rbtree_insert_batch(block, arr, n);
+    assert(block->heap_nodes == 0);
+
+    // block and heap nodes mixed (inserts use up the last block before the heap)
+    rbtree *mixed = new_rbtree();
+    rbtree_insert_batch(mixed, arr, n);
+    const size_t spare = count_free_nodes(mixed);
+    insert_arr(mixed, arr, n / 2);
+    assert(mixed->heap_nodes == n / 2 - spare);
+
+    rbtree_delete_async(heap);
+    rbtree_delete_async(block);
+    delete_rbtree(mixed);
+  }
+  rbtree_reclaim_wait();
+
+  free(arr);
+}
+
+// hash index should stay in sync with insert/erase, including duplicates
+void test_hash_index(const size_t n, const unsigned int seed) {
+  srand(seed);
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (size_t i = 0; i < n; i++) {
+    arr[i] = rand() % (int)(n / 4);  // with duplicates
+  }
+
+  rbtree *t = new_rbtree();
+  insert_arr(t, arr, n / 2);
+  rbtree_enable_hash_index(t);  // built from existing nodes
+  insert_arr(t, arr + n / 2, n / 4);
+  rbtree_insert_batch(t, arr + n / 2 + n / 4, n - n / 2 - n / 4);
+  test_color_constraint(t);
+
+  for (size_t i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+  }
+  assert(rbtree_find(t, -1) == NULL);
+
+  // erase every copy; index entries must follow the key moved by erase
+  for (size_t i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL && p->key == arr[i]);
+    rbtree_erase(t, p);
+  }
+  for (size_t i = 0; i < n; i++) {
+    assert(rbtree_find(t, arr[i]) == NULL);
+  }
+  assert(t->root == t->nil);
+
+  // lazy erase removes dead nodes from the index right away
+  rbtree_set_lazy_erase(t, 0.5);
+  insert_arr(t, arr, n);
+  for (size_t i = 0; i < n; i += 2) {
+    rbtree_erase(t, rbtree_find(t, arr[i]));
+  }
+  key_t *live = calloc(n, sizeof(key_t));
+  size_t m = 0;
+  for (size_t i = 1; i < n; i += 2) {
+    live[m++] = arr[i];
+  }
+  qsort((void *)live, m, sizeof(key_t), comp);
+  assert_tree_keys(t, live, m);
+  for (size_t i = 0; i < m; i++) {
+    node_t *p = rbtree_find(t, live[i]);
+    assert(p != NULL && !(p->flags & NODE_DEAD));
+  }
+
+  rbtree_disable_hash_index(t);
+  for (size_t i = 0; i < m; i++) {
+    assert(rbtree_find(t, live[i]) != NULL);
+  }
+  delete_rbtree(t);
+
+  // many copies of one key share a slot, which must follow the erased copies
+  t = new_rbtree();
+  rbtree_enable_hash_index(t);
+  for (size_t i = 0; i < n; i++) {
+    rbtree_insert(t, 7);
+    rbtree_insert(t, (key_t)i % 5);
+  }
+  for (size_t i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, 7);
+    assert(p != NULL && p->key == 7);
+    rbtree_erase(t, p);
+    p = rbtree_find(t, (key_t)i % 5);
+    assert(p != NULL && p->key == (key_t)i % 5);
+    rbtree_erase(t, p);
+  }
+  assert(rbtree_find(t, 7) == NULL);
+  assert(t->root == t->nil);
+
+  free(live);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// AVL: stored rank is the subtree height and children differ by at most 1
+// WAVL: rank differences are 1 or 2 and leaves have rank 0 (stored as 1)
+static int rank_traverse(const node_t *p, const node_t *nil,
+                         const balance_t balance) {
+  if (p == nil) {
+    return p->rank == 0;
+  }
+  if (!rank_traverse(p->left, nil, balance) ||
+      !rank_traverse(p->right, nil, balance)) {
+    return 0;
+  }
+  const int l = p->rank - p->left->rank, r = p->rank - p->right->rank;
+  if (balance == RBTREE_BALANCE_AVL) {
+    return (l == 1 && (r == 1 || r == 2)) || (r == 1 && l == 2);
+  }
+  if (p->left == nil && p->right == nil && p->rank != 1) {
+    return 0;
+  }
+  return l >= 1 && l <= 2 && r >= 1 && r <= 2;
+}
+
+void test_rank_constraint(const rbtree *t) {
+  assert(rank_traverse(t->root, t->nil, t->balance));
+}
+
+// AVL and WAVL trees should keep their rank rules through insert/erase
+void test_balance_engines(const size_t n, const unsigned int seed) {
+  const balance_t engines[] = {RBTREE_BALANCE_AVL, RBTREE_BALANCE_WAVL};
+  for (size_t e = 0; e < 2; e++) {
+    srand(seed);
+    key_t *arr = calloc(n, sizeof(key_t));
+    for (size_t i = 0; i < n; i++) {
+      arr[i] = rand() % (int)(n / 2);  // with duplicates
+    }
+
+    rbtree *t = new_rbtree_with_balance(engines[e]);
+    assert(t->balance == engines[e]);
+    for (size_t i = 0; i < n; i++) {
+      rbtree_insert(t, arr[i]);
+      if (i % 97 == 0) {
+        test_rank_constraint(t);
+      }
+    }
+    test_rank_constraint(t);
+    test_search_constraint(t);
+
+    key_t *sorted = calloc(n, sizeof(key_t));
+    memcpy(sorted, arr, n * sizeof(key_t));
+    qsort((void *)sorted, n, sizeof(key_t), comp);
+    assert_tree_keys(t, sorted, n);
+
+    for (size_t i = 0; i < n; i++) {
+      node_t *p = rbtree_find(t, arr[i]);
+      assert(p != NULL && p->key == arr[i]);
+      rbtree_erase(t, p);
+      if (i % 97 == 0) {
+        test_rank_constraint(t);
+        test_search_constraint(t);
+      }
+    }
+    assert(t->root == t->nil);
+
+    // batch rebuild and finger insert
+    rbtree_insert_batch(t, arr, n / 2);
+    test_rank_constraint(t);
+    rbtree_insert_batch(t, arr + n / 2, n / 8);
+    test_rank_constraint(t);
+    test_search_constraint(t);
+    delete_rbtree(t);
+
+    t = new_rbtree_with_balance(engines[e]);
+    erase_min_lazily(t, arr, n);
+    test_rank_constraint(t);
+
+    free(sorted);
+    free(arr);
+    delete_rbtree(t);
+
+    test_find_erase_fixed_with(engines[e]);
+  }
+}
+
 int main(void) {
   test_init();
   test_insert_single(1024);
@@ -379,5 +1123,16 @@ int main(void) {
   test_duplicate_values();
   test_multi_instance();
   test_find_erase_rand(10000, 17);
+  test_str_rbtree();
+  test_str_arena_churn(1000, 50);
+  test_durable_rbtree();
+  test_durable_group_commit();
+  test_durable_checkpoint(1000);
+  test_insert_batch(10000, 29);
+  test_lazy_erase(10000, 31);
+  test_rbset();
+  test_delete_async(10000, 37);
+  test_hash_index(10000, 41);
+  test_balance_engines(10000, 43);
   printf("Passed all tests!\n");
 }